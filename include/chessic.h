@@ -21,6 +21,9 @@
 #define CSC_MAX_MOVES 250
 #define CSC_MAX_GAME_LENGTH 6000
 
+#define CSC_NO_MOVE 0
+#define CSC_NUM_KILLERS 2
+
 #define CSC_MAX_FEN_LENGTH 100
 #define CSC_MAX_UCI_MOVE_LENGTH 6
 
@@ -54,6 +57,14 @@ enum CSC_RayType
     CSC_DIAGONAL
 };
 
+/* The implementations available for looking up sliding piece attacks. */
+enum CSC_SliderBackend
+{
+    CSC_SLIDER_RAYSCAN,
+    CSC_SLIDER_MAGIC,
+    CSC_SLIDER_PEXT
+};
+
 enum CSC_Colour
 {
     CSC_WHITE,
@@ -83,11 +94,14 @@ enum CSC_MoveType
     CSC_QUEENCASTLE = CSC_CASTLE | 32
 };
 
+/* These can be combined, e.g. CSC_CAPTURES | CSC_QUIET_CHECKS gives the
+   moves normally searched in quiescence. */
 enum CSC_MoveGenType
 {
     CSC_QUIETS = 1,
     CSC_CAPTURES = 2,
-    CSC_ALL = CSC_QUIETS | CSC_CAPTURES
+    CSC_ALL = CSC_QUIETS | CSC_CAPTURES,
+    CSC_QUIET_CHECKS = 4
 };
 
 struct CSC_MoveList
@@ -96,6 +110,38 @@ struct CSC_MoveList
     int n;
 };
 
+/* Returns the legal moves in a position one at a time, in stages: the hash
+   move, captures which don't lose material (most valuable victim/least
+   valuable attacker first), killer moves, the remaining quiet moves and then
+   the captures which lose material. Each stage is only generated when the
+   previous one is exhausted. This should be set up using
+   CSC_InitMovePicker. */
+struct CSC_MovePicker
+{
+    /* The position to pick moves for. */
+    struct CSC_Board* board;
+
+    /* The current stage of move generation. */
+    int stage;
+
+    /* The moves to try before generating anything (these may be
+       CSC_NO_MOVE). */
+    CSC_Move hashMove;
+    CSC_Move killers[CSC_NUM_KILLERS];
+
+    /* The moves generated for the current stage and their scores. */
+    CSC_Move moves[CSC_MAX_MOVES];
+    int scores[CSC_MAX_MOVES];
+    int numMoves;
+
+    /* The index of the next move to consider in the current stage. */
+    int current;
+
+    /* The captures which lose material are kept at the start of the moves
+       until the quiet moves have been tried. */
+    int numBadCaptures;
+};
+
 struct CSC_CastlingRights
 {
     /* Whether the player can castle kingside. */
@@ -126,14 +172,69 @@ struct CSC_Board
     void* states;
 };
 
+/* A fixed-size position without any history, which can be copied by value
+   (e.g. for copy-make search or to give each thread its own position). */
+struct CSC_Position
+{
+    /* All pieces for each player. */
+    CSC_Bitboard all[2];
+
+    /* The pieces of each type for each player. */
+    CSC_Bitboard pieces[7][2];
+
+    /* The position hash (the same as the equivalent board's hash). */
+    CSC_Hash hash;
+
+    /* The pieces on each square. */
+    uint8_t squares[CSC_SQUARE_NB];
+
+    /* The player to move. */
+    uint8_t player;
+
+    /* The castling rights, where bit 2*colour is set if the player can castle
+       kingside and bit 2*colour+1 if they can castle queenside. */
+    uint8_t castling;
+
+    /* The index of the square where an en-passent capture is possible. */
+    int8_t enPassentIndex;
+
+    /* The number of plies since the last move that reset the 50 move rule. */
+    uint16_t plies50Move;
+
+    /* The number of full turns so far. */
+    uint16_t turnNumber;
+};
+
+/* The pieces which were added to or removed from the board by the last move
+   (up to four for castling), e.g. for updating an evaluation incrementally. */
+#define CSC_MAX_DIRTY_PIECES 4
+
+struct CSC_DirtyPieces
+{
+    /* The number of changes. */
+    int n;
+
+    /* The piece, where it was added or removed and whether it was added, for
+       each change in the order they were made. */
+    CSC_Piece pieces[CSC_MAX_DIRTY_PIECES];
+    uint8_t locs[CSC_MAX_DIRTY_PIECES];
+    bool added[CSC_MAX_DIRTY_PIECES];
+};
+
 /* Bitboard constants. */
 EXPORT extern CSC_Bitboard CSC_Ranks[8];
 EXPORT extern CSC_Bitboard CSC_Files[8];
 EXPORT extern CSC_Bitboard CSC_KnightAttacks[64];
 EXPORT extern CSC_Bitboard CSC_KingAttacks[64];
+EXPORT extern CSC_Bitboard CSC_PawnAttacks[2][64];
 EXPORT extern CSC_Bitboard CSC_RayAttacks[64][8];
 EXPORT extern CSC_Bitboard CSC_RayAttacksAll[64][2];
 
+/* The squares strictly between two squares and the full line through them
+   (both are empty if the squares are not on a shared rank, file or diagonal). */
+EXPORT extern CSC_Bitboard CSC_Between[64][64];
+EXPORT extern CSC_Bitboard CSC_Line[64][64];
+
 /* Initialisation functions which must be called first. */
 EXPORT void CSC_InitBits();
 EXPORT void CSC_InitZobrist();
@@ -143,44 +244,156 @@ EXPORT int CSC_PopLSB(CSC_Bitboard*);
 EXPORT int CSC_PopMSB(CSC_Bitboard*);
 EXPORT int CSC_LSB(CSC_Bitboard);
 EXPORT int CSC_MSB(CSC_Bitboard);
+EXPORT int CSC_PopCount(CSC_Bitboard);
 EXPORT bool CSC_Test(CSC_Bitboard, int);
 EXPORT void CSC_PrintBitboard(CSC_Bitboard);
 
+/* Get the squares attacked by a rook or bishop on the given square with the
+   specified occupancy. */
+EXPORT CSC_Bitboard CSC_RookAttacks(int, CSC_Bitboard);
+EXPORT CSC_Bitboard CSC_BishopAttacks(int, CSC_Bitboard);
+
+/* The slider backend is chosen by CSC_InitBits (PEXT if the CPU supports BMI2
+   and magic bitboards otherwise). Setting the backend returns false if it is
+   not supported on this machine. This is not thread-safe. */
+EXPORT enum CSC_SliderBackend CSC_GetSliderBackend();
+EXPORT bool CSC_SetSliderBackend(enum CSC_SliderBackend);
+
 /* Methods for creating and interacting with the board. */
 EXPORT struct CSC_Board* CSC_BoardFromFEN(const char*);
 EXPORT void CSC_FENFromBoard(struct CSC_Board*, char*, int*);
 EXPORT struct CSC_Board* CSC_CopyBoard(struct CSC_Board*);
 EXPORT bool CSC_BoardEqual(struct CSC_Board*, struct CSC_Board*);
 EXPORT void CSC_FreeBoard(struct CSC_Board*);
+
+/* Make space in the board's history for at least the given number of moves
+   beyond the current one (e.g. the maximum search depth), so that making
+   moves never has to grow it. */
+EXPORT void CSC_ReserveHistory(struct CSC_Board*, int);
 EXPORT void CSC_PrintBoard(struct CSC_Board*);
 EXPORT CSC_Hash CSC_GetHash(struct CSC_Board*);
 EXPORT int CSC_GetEnPassentIndex(struct CSC_Board*);
 EXPORT int CSC_GetPlies50Move(struct CSC_Board*);
 
+/* Get the pieces which were added and removed by the last move (there are no
+   changes for a null move or if no moves have been made). */
+EXPORT const struct CSC_DirtyPieces* CSC_GetLastMoveDelta(struct CSC_Board*);
+
+/* Get a hash of the pawns (e.g. for a pawn structure cache). */
+EXPORT CSC_Hash CSC_GetPawnHash(struct CSC_Board*);
+
+/* Get a hash of the number of each type of piece (e.g. for a material
+   imbalance table). This only depends on the material, not where it is. */
+EXPORT uint32_t CSC_GetMaterialKey(struct CSC_Board*);
+
 struct CSC_CastlingRights CSC_GetCastlingRights(
     struct CSC_Board*,
     enum CSC_Colour);
 
+/* Convert between boards and positions. Positions don't store the history so
+   a board created from a position has no previous moves. */
+EXPORT void CSC_PositionFromBoard(struct CSC_Board*, struct CSC_Position*);
+EXPORT struct CSC_Board* CSC_BoardFromPosition(const struct CSC_Position*);
+
+/* Make the move in the position, writing the result to the output position
+   (which can be the same as the input). */
+EXPORT void CSC_PositionMakeMove(
+    const struct CSC_Position*,
+    CSC_Move,
+    struct CSC_Position*);
+
 /* Check whether the board is in a drawn state. */
 EXPORT bool CSC_IsDrawn(struct CSC_Board*);
 
-/* Check whether the specified move is legal in the given board state. */
+/* Check whether the player to move has a move (ignoring legality) that goes
+   back to an earlier position. Positions from the last ply plies (e.g. since
+   the root of the search) count if they have occurred once, and older ones
+   only if they have already occurred twice. */
+EXPORT bool CSC_HasUpcomingRepetition(struct CSC_Board*, int ply);
+
+/* Check whether the move is valid in the given board state apart from leaving
+   the king in check (the move can be any value, e.g. from a hash table). */
+EXPORT bool CSC_IsPseudoLegal(struct CSC_Board*, CSC_Move);
+
+/* Check whether the specified move is legal in the given board state. The
+   move must be pseudo-legal. */
 EXPORT bool CSC_IsLegal(struct CSC_Board*, CSC_Move);
 
-/* Generate pseudo-legal moves. */
+/* Generate legal moves of the specified type (none if the game is drawn). */
 EXPORT void CSC_GetMoves(
     struct CSC_Board*,
     struct CSC_MoveList*,
     enum CSC_MoveGenType);
 
+/* Count the legal moves of the specified type (zero if the game is drawn).
+   This is faster than generating them. */
+EXPORT int CSC_CountMoves(struct CSC_Board*, enum CSC_MoveGenType);
+
+/* Generate or count legal moves of the specified type without checking whether
+   the game is drawn (e.g. for perft, or when a search checks for draws
+   itself). */
+EXPORT void CSC_GetMovesNoDrawCheck(
+    struct CSC_Board*,
+    struct CSC_MoveList*,
+    enum CSC_MoveGenType);
+
+EXPORT int CSC_CountMovesNoDrawCheck(struct CSC_Board*, enum CSC_MoveGenType);
+
+/* Start picking moves in the given position. The killer moves should be an
+   array of size CSC_NUM_KILLERS (or NULL). The board must not be changed
+   while picking moves, other than making and undoing moves in between calls
+   to CSC_NextMove. */
+EXPORT void CSC_InitMovePicker(
+    struct CSC_MovePicker*,
+    struct CSC_Board*,
+    CSC_Move hashMove,
+    CSC_Move* killers);
+
+/* Get the next legal move (or CSC_NO_MOVE if there are no more). Unlike
+   CSC_GetMoves this does not check whether the game is drawn. */
+EXPORT CSC_Move CSC_NextMove(struct CSC_MovePicker*);
+
 /* Attempt to make the move (returns false if it's illegal). */
 EXPORT void CSC_MakeMove(struct CSC_Board*, CSC_Move);
 
 /* Undo the last made move. */
 EXPORT void CSC_UndoMove(struct CSC_Board*);
 
+/* Pass the turn to the other player. The player to move must not be in check.
+   Repetitions are not counted across a null move. */
+EXPORT void CSC_MakeNullMove(struct CSC_Board*);
+
+/* Undo the last made null move. */
+EXPORT void CSC_UndoNullMove(struct CSC_Board*);
+
 EXPORT bool CSC_IsAttacked(struct CSC_Board*, int);
 
+/* Check whether the move gives check without making it. The move must be
+   legal. */
+EXPORT bool CSC_GivesCheck(struct CSC_Board*, CSC_Move);
+
+/* Check whether the player to move is in check, and get the pieces giving
+   check. These are found when the move is made so are cheap to query. */
+EXPORT bool CSC_InCheck(struct CSC_Board*);
+EXPORT CSC_Bitboard CSC_GetCheckers(struct CSC_Board*);
+
+/* Get the pieces of both colours which attack the location given the
+   specified occupancy (sliders are blocked by the occupied squares). */
+EXPORT CSC_Bitboard CSC_AttackersTo(struct CSC_Board*, int, CSC_Bitboard);
+
+/* Static exchange evaluation: the material gained by the player to move from
+   the sequence of captures on the move's end square which starts with the
+   move, where each side recaptures with its least valuable piece and can stop
+   when it is ahead. The values are 100 for a pawn, 300 for a knight or bishop,
+   500 for a rook and 900 for a queen. Pins and recaptures which promote are
+   not taken into account. */
+EXPORT int CSC_SEE(struct CSC_Board*, CSC_Move);
+
+/* Check whether the static exchange evaluation of the move is at least the
+   threshold. This is faster than CSC_SEE since it stops as soon as the
+   result is known. */
+EXPORT bool CSC_SEEGreaterOrEqual(struct CSC_Board*, CSC_Move, int);
+
 /* Methods for creating and interacting with pieces. */
 #define CSC_CreatePiece(col, pt) (col + ((pt) << 1))
 #define CSC_GetPieceColour(p)    (p & 0x1)
@@ -5,12 +5,50 @@
 #include "intrin.h"
 #endif
 
+/* PEXT is only available on x86 and has to be enabled per-function (with GCC
+   or clang) so that the rest of the library runs on CPUs without BMI2. */
+#if defined(_MSC_VER) && defined(_M_X64)
+#define CSC_PEXT_SUPPORTED
+#include "immintrin.h"
+#define TARGET_BMI2
+#elif defined(__GNUC__) && defined(__x86_64__)
+#define CSC_PEXT_SUPPORTED
+#include "immintrin.h"
+#define TARGET_BMI2 __attribute__((target("bmi2")))
+#endif
+
 CSC_Bitboard CSC_Ranks[8];
 CSC_Bitboard CSC_Files[8];
 CSC_Bitboard CSC_KnightAttacks[64];
 CSC_Bitboard CSC_KingAttacks[64];
+CSC_Bitboard CSC_PawnAttacks[2][64];
 CSC_Bitboard CSC_RayAttacks[64][8];
 CSC_Bitboard CSC_RayAttacksAll[64][2];
+CSC_Bitboard CSC_Between[64][64];
+CSC_Bitboard CSC_Line[64][64];
+
+/* The sliding attack lookup for a single square ("fancy" magic bitboards).
+   The relevant occupancy is multiplied by the magic number and the top bits of
+   the product are used to index into this square's slice of the table. */
+struct Magic
+{
+    CSC_Bitboard mask;
+    CSC_Bitboard magic;
+    CSC_Bitboard* attacks;
+    int shift;
+};
+
+struct Magic rookMagics[64];
+struct Magic bishopMagics[64];
+
+/* Each square needs 2^(bits in mask) entries. Summing over all squares gives
+   the sizes of the shared tables. */
+CSC_Bitboard rookTable[0x19000];
+CSC_Bitboard bishopTable[0x1480];
+
+enum CSC_SliderBackend sliderBackend;
+CSC_Bitboard (*rookAttacks)(int, CSC_Bitboard);
+CSC_Bitboard (*bishopAttacks)(int, CSC_Bitboard);
 
 void InitSteppers()
 {
@@ -42,6 +80,12 @@ void InitSteppers()
 
             CSC_KnightAttacks[8*r+f] = nc;
             CSC_KingAttacks[8*r+f] = kc;
+
+            /* Pawn captures (these are the squares the pawn attacks). */
+            CSC_PawnAttacks[CSC_WHITE][8*r+f] = kc & (r < 7 ? CSC_Ranks[r+1] : 0);
+            CSC_PawnAttacks[CSC_WHITE][8*r+f] &= ~CSC_Files[f];
+            CSC_PawnAttacks[CSC_BLACK][8*r+f] = kc & (r > 0 ? CSC_Ranks[r-1] : 0);
+            CSC_PawnAttacks[CSC_BLACK][8*r+f] &= ~CSC_Files[f];
         }
     }
 }
@@ -175,8 +219,292 @@ void InitRays()
     }
 }
 
+/* Initialise the squares between (and the lines through) pairs of squares.
+   These are empty for squares which don't share a rank, file or diagonal. */
+void InitLines()
+{
+    /* The opposite of each direction (see enum CSC_Directions). */
+    static const enum CSC_Directions opposite[8] =
+    {
+        CSC_SOUTH, CSC_NORTH, CSC_EAST, CSC_WEST,
+        CSC_SOUTHWEST, CSC_SOUTHEAST, CSC_NORTHWEST, CSC_NORTHEAST
+    };
+
+    CSC_Bitboard ray, targets;
+    int s1, s2, d;
+
+    for (s1 = 0; s1 < 64; s1++)
+    {
+        for (d = 0; d < 8; d++)
+        {
+            ray = CSC_RayAttacks[s1][d];
+            targets = ray;
+            while (targets)
+            {
+                s2 = CSC_PopLSB(&targets);
+
+                CSC_Between[s1][s2] =
+                    ray & ~CSC_RayAttacks[s2][d] & ~((CSC_Bitboard)1 << s2);
+
+                CSC_Line[s1][s2] = ray
+                    | CSC_RayAttacks[s1][opposite[d]]
+                    | ((CSC_Bitboard)1 << s1);
+            }
+        }
+    }
+}
+
+/* Find the attacks for a slider by scanning along each of its four rays in
+   turn and stopping at the first blocker. This is too slow to use during move
+   generation but it is used to populate the magic bitboard tables. */
+CSC_Bitboard RayScanAttacks(
+    int loc,
+    CSC_Bitboard occ,
+    const enum CSC_Directions* dirs)
+{
+    CSC_Bitboard attacks = 0, ray, blockers;
+    int d;
+
+    /* The first 2 directions are positive and the last 2 are negative. */
+    for (d = 0; d < 4; d++)
+    {
+        ray = CSC_RayAttacks[loc][dirs[d]];
+        blockers = ray & occ;
+        if (blockers)
+        {
+            ray ^= CSC_RayAttacks[
+                d < 2 ? CSC_LSB(blockers) : CSC_MSB(blockers)][dirs[d]];
+        }
+
+        attacks |= ray;
+    }
+
+    return attacks;
+}
+
+/* Magic numbers for each square. These were found by trying sparse random
+   numbers until one mapped every relevant occupancy to an index without a
+   destructive collision. */
+const CSC_Bitboard rookMagicNumbers[64] =
+{
+    0x0A80004000801220, 0x8040004010002008, 0x2080200010008008,
+    0x1100100008210004, 0xC200209084020008, 0x2100010004000208,
+    0x0400081000822421, 0x0200010422048844, 0x0800800080400024,
+    0x0001402000401000, 0x3000801000802001, 0x4400800800100083,
+    0x0904802402480080, 0x4040800400020080, 0x0018808042000100,
+    0x4040800080004100, 0x0100828000400027, 0x0100808040002000,
+    0x0046420010822200, 0x1008008010000881, 0x2000808008000400,
+    0x2406008080020400, 0x2502040002010890, 0x010072000401814F,
+    0x0080004100210080, 0xA010004840002004, 0x8012244600120080,
+    0x9022002200081040, 0x2400080080040081, 0x0012008080040002,
+    0xE001000100020004, 0x2041284200048304, 0x8042244009800880,
+    0x0000804010802000, 0x4301842004801002, 0x04410008A5001000,
+    0x022200A006000810, 0x2000100408014020, 0x0000024124003008,
+    0x0000051842000184, 0x4000804000218000, 0x0400810040010021,
+    0x2030016804012000, 0x0024100100210008, 0xA804040008008080,
+    0x0401000804010002, 0x000A000104420008, 0x0200008041020004,
+    0x8000250058800100, 0x1080200040100040, 0x0020408012002200,
+    0x0006100280080080, 0x0102001008202600, 0x2800800200040080,
+    0x0103000200045100, 0x0020404094010A00, 0x000C108141012202,
+    0x000C108141012202, 0xA002800810224202, 0x000004E010010109,
+    0x2002000408102002, 0x4002000801041016, 0x0000208128100224,
+    0x40000040210C0882
+};
+
+const CSC_Bitboard bishopMagicNumbers[64] =
+{
+    0x40106000A1160020, 0x0020010250810120, 0x2010010220280081,
+    0x002806004050C040, 0x0002021018000000, 0x2001112010000400,
+    0x0881010120218080, 0x1030820110010500, 0x0000120222042400,
+    0x2000020404040044, 0x8000480094208000, 0x0003422A02000001,
+    0x000A220210100040, 0x8004820202226000, 0x0018234854100800,
+    0x0100004042101040, 0x0260000862900200, 0x001841020A044400,
+    0x0002110400240101, 0x120800042201A200, 0x1504001080A05000,
+    0x0805000200809480, 0x004C4C0094100800, 0x8040200303211020,
+    0x0004047040084802, 0x0006300092504208, 0x0108021004040010,
+    0x0920080005004208, 0x0015001001024008, 0x0004024801012004,
+    0x0901040811008801, 0x5000488000420804, 0x0004024058210400,
+    0x00080825000A4410, 0x0442023000020080, 0x0010020080080081,
+    0x0401090401020020, 0x1220008900098440, 0x000404004100A800,
+    0x00080048810300A4, 0x8091080310404001, 0x2826209008842400,
+    0x00B0104030000800, 0x0200004208000080, 0x0502080104000840,
+    0x0820608102000040, 0x8823142404000085, 0x4E41010101000208,
+    0x0000808410400005, 0x400A008C04420080, 0x0802008098210002,
+    0x0200000320884600, 0x20880010021A0020, 0x0800400408408008,
+    0x80652104010A0000, 0x80652104010A0000, 0x8005208208B04000,
+    0x090001011082200B, 0x0000C90080480823, 0x1000084200A0A80C,
+    0x2000021040050100, 0x0000122048491844, 0x2012409002408104,
+    0x00A001A101040082
+};
+
+/* Set up the mask and magic number for each square and divide up the table
+   between the squares. */
+void InitMagics(
+    struct Magic* magics,
+    CSC_Bitboard* table,
+    const CSC_Bitboard* magicNumbers,
+    const enum CSC_Directions* dirs)
+{
+    CSC_Bitboard edges;
+    struct Magic* m;
+    int loc;
+
+    for (loc = 0; loc < 64; loc++)
+    {
+        m = &magics[loc];
+
+        /* Pieces on the edge of the board never block anything further along
+           the ray, so they are excluded from the relevant occupancy. */
+        edges = ((CSC_Ranks[0] | CSC_Ranks[7]) & ~CSC_Ranks[loc / 8])
+              | ((CSC_Files[0] | CSC_Files[7]) & ~CSC_Files[loc % 8]);
+
+        m->mask = RayScanAttacks(loc, 0, dirs) & ~edges;
+        m->magic = magicNumbers[loc];
+        m->shift = 64 - CSC_PopCount(m->mask);
+        m->attacks = loc == 0
+            ? table
+            : magics[loc-1].attacks + ((CSC_Bitboard)1 << (64 - magics[loc-1].shift));
+    }
+}
+
+/* Fill in the attack table for each square. The table is indexed differently
+   depending on whether the magic number or PEXT is used to compress the
+   occupancy. */
+void FillAttackTables(
+    struct Magic* magics,
+    const enum CSC_Directions* dirs,
+    bool pext)
+{
+    CSC_Bitboard b;
+    struct Magic* m;
+    int loc, idx;
+
+    for (loc = 0; loc < 64; loc++)
+    {
+        m = &magics[loc];
+
+        /* Enumerate all subsets of the mask (Carry-Rippler). The subsets come
+           out in the same order as PEXT would number them. */
+        idx = 0;
+        b = 0;
+        do
+        {
+            m->attacks[pext ? idx : (int)((b * m->magic) >> m->shift)] =
+                RayScanAttacks(loc, b, dirs);
+
+            ++idx;
+            b = (b - m->mask) & m->mask;
+        }
+        while (b);
+    }
+}
+
+CSC_Bitboard RayScanRookAttacks(int loc, CSC_Bitboard occ)
+{
+    static const enum CSC_Directions orth[4] =
+        { CSC_NORTH, CSC_EAST, CSC_SOUTH, CSC_WEST };
+    return RayScanAttacks(loc, occ, orth);
+}
+
+CSC_Bitboard RayScanBishopAttacks(int loc, CSC_Bitboard occ)
+{
+    static const enum CSC_Directions diag[4] =
+        { CSC_NORTHEAST, CSC_NORTHWEST, CSC_SOUTHEAST, CSC_SOUTHWEST };
+    return RayScanAttacks(loc, occ, diag);
+}
+
+CSC_Bitboard MagicRookAttacks(int loc, CSC_Bitboard occ)
+{
+    struct Magic* m = &rookMagics[loc];
+    return m->attacks[((occ & m->mask) * m->magic) >> m->shift];
+}
+
+CSC_Bitboard MagicBishopAttacks(int loc, CSC_Bitboard occ)
+{
+    struct Magic* m = &bishopMagics[loc];
+    return m->attacks[((occ & m->mask) * m->magic) >> m->shift];
+}
+
+#ifdef CSC_PEXT_SUPPORTED
+TARGET_BMI2 CSC_Bitboard PextRookAttacks(int loc, CSC_Bitboard occ)
+{
+    struct Magic* m = &rookMagics[loc];
+    return m->attacks[_pext_u64(occ, m->mask)];
+}
+
+TARGET_BMI2 CSC_Bitboard PextBishopAttacks(int loc, CSC_Bitboard occ)
+{
+    struct Magic* m = &bishopMagics[loc];
+    return m->attacks[_pext_u64(occ, m->mask)];
+}
+#endif
+
+/* Check whether the CPU we're running on supports BMI2 (and so PEXT). */
+bool CPUSupportsPext()
+{
+#if defined(CSC_PEXT_SUPPORTED) && defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, 7, 0);
+    return (regs[1] >> 8) & 1;
+#elif defined(CSC_PEXT_SUPPORTED)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+bool CSC_SetSliderBackend(enum CSC_SliderBackend backend)
+{
+    static const enum CSC_Directions orth[4] =
+        { CSC_NORTH, CSC_EAST, CSC_SOUTH, CSC_WEST };
+    static const enum CSC_Directions diag[4] =
+        { CSC_NORTHEAST, CSC_NORTHWEST, CSC_SOUTHEAST, CSC_SOUTHWEST };
+
+    switch (backend)
+    {
+        case CSC_SLIDER_RAYSCAN:
+            rookAttacks = &RayScanRookAttacks;
+            bishopAttacks = &RayScanBishopAttacks;
+            break;
+        case CSC_SLIDER_MAGIC:
+            FillAttackTables(rookMagics, orth, false);
+            FillAttackTables(bishopMagics, diag, false);
+            rookAttacks = &MagicRookAttacks;
+            bishopAttacks = &MagicBishopAttacks;
+            break;
+        case CSC_SLIDER_PEXT:
+#ifdef CSC_PEXT_SUPPORTED
+            if (!CPUSupportsPext()) return false;
+            FillAttackTables(rookMagics, orth, true);
+            FillAttackTables(bishopMagics, diag, true);
+            rookAttacks = &PextRookAttacks;
+            bishopAttacks = &PextBishopAttacks;
+            break;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+
+    sliderBackend = backend;
+
+    return true;
+}
+
+enum CSC_SliderBackend CSC_GetSliderBackend()
+{
+    return sliderBackend;
+}
+
 void CSC_InitBits()
 {
+    static const enum CSC_Directions orth[4] =
+        { CSC_NORTH, CSC_EAST, CSC_SOUTH, CSC_WEST };
+    static const enum CSC_Directions diag[4] =
+        { CSC_NORTHEAST, CSC_NORTHWEST, CSC_SOUTHEAST, CSC_SOUTHWEST };
+
     int i;
     CSC_Ranks[0] = 0xFF;
     for (i = 1; i < 8; i++) CSC_Ranks[i] = CSC_Ranks[i-1] << 8;
@@ -186,6 +514,25 @@ void CSC_InitBits()
 
     InitSteppers();
     InitRays();
+    InitLines();
+    InitMagics(rookMagics, rookTable, rookMagicNumbers, orth);
+    InitMagics(bishopMagics, bishopTable, bishopMagicNumbers, diag);
+
+    /* Prefer PEXT if the CPU supports it, otherwise use the magic numbers. */
+    if (!CSC_SetSliderBackend(CSC_SLIDER_PEXT))
+    {
+        CSC_SetSliderBackend(CSC_SLIDER_MAGIC);
+    }
+}
+
+CSC_Bitboard CSC_RookAttacks(int loc, CSC_Bitboard occ)
+{
+    return rookAttacks(loc, occ);
+}
+
+CSC_Bitboard CSC_BishopAttacks(int loc, CSC_Bitboard occ)
+{
+    return bishopAttacks(loc, occ);
 }
 
 int CSC_PopLSB(CSC_Bitboard* board)
@@ -224,6 +571,15 @@ int CSC_MSB(CSC_Bitboard board)
     return bit;
 }
 
+int CSC_PopCount(CSC_Bitboard board)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt64(board);
+#else
+    return __builtin_popcountll(board);
+#endif
+}
+
 bool CSC_Test(CSC_Bitboard board, int loc)
 {
     return board & ((CSC_Bitboard)1 << loc);
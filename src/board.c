@@ -77,15 +77,143 @@ int CSC_GetPlies50Move(struct CSC_Board* b)
     return bs->plies50Move;
 }
 
+const struct CSC_DirtyPieces* CSC_GetLastMoveDelta(struct CSC_Board* b)
+{
+    struct DerivedState* ds = TopDerived((struct StateStack*)b->states);
+
+    if (!ds->dirtyValid)
+    {
+        FindDirtyPieces(b, Top((struct StateStack*)b->states), &ds->dirty);
+        ds->dirtyValid = true;
+    }
+
+    return &ds->dirty;
+}
+
+CSC_Hash CSC_GetPawnHash(struct CSC_Board* b)
+{
+    struct BoardState* bs = Top((struct StateStack*)b->states);
+    return bs->pawnHash;
+}
+
+uint32_t CSC_GetMaterialKey(struct CSC_Board* b)
+{
+    struct BoardState* bs = Top((struct StateStack*)b->states);
+    return bs->materialKey;
+}
+
+void SetPieceKeys(struct CSC_Board* b, struct BoardState* bs)
+{
+    CSC_Bitboard pawns;
+    int p, pt, n;
+
+    bs->pawnHash = 0;
+    bs->materialKey = 0;
+
+    for (p = CSC_WHITE; p <= CSC_BLACK; p++)
+    {
+        pawns = b->pieces[CSC_PAWN][p];
+        while (pawns)
+        {
+            bs->pawnHash ^= keys.pieceSquare[p][CSC_PAWN][CSC_PopLSB(&pawns)];
+        }
+
+        for (pt = CSC_PAWN; pt <= CSC_KING; pt++)
+        {
+            for (n = 0; n < CSC_PopCount(b->pieces[pt][p]); n++)
+            {
+                bs->materialKey ^= MaterialKey(p, pt, n);
+            }
+        }
+    }
+}
+
 struct CSC_CastlingRights CSC_GetCastlingRights(
     struct CSC_Board* b,
     enum CSC_Colour p)
 {
     struct BoardState* bs = Top((struct StateStack*)b->states);
-    return bs->castlingRights[p];
+    struct CSC_CastlingRights rights;
+
+    rights.kingSide = (bs->castling & CASTLE_KINGSIDE(p)) != 0;
+    rights.queenSide = (bs->castling & CASTLE_QUEENSIDE(p)) != 0;
+
+    return rights;
 }
 
-CSC_Piece RemovePiece(struct CSC_Board* b, int loc, CSC_Hash* hash)
+void AddDirtyPiece(
+    struct CSC_DirtyPieces* dirty,
+    CSC_Piece pc,
+    int loc,
+    bool added)
+{
+    dirty->pieces[dirty->n] = pc;
+    dirty->locs[dirty->n] = loc;
+    dirty->added[dirty->n++] = added;
+}
+
+/* Work out the changes made by the last move from the board after it. These
+   are in the same order as CSC_MakeMove records them. */
+void FindDirtyPieces(
+    struct CSC_Board* b,
+    struct BoardState* bs,
+    struct CSC_DirtyPieces* dirty)
+{
+    CSC_Move m = bs->lastMove;
+    int p = 1 - b->player;
+    int s = CSC_GetMoveStart(m);
+    int e = CSC_GetMoveEnd(m);
+    int castleRank = p == CSC_WHITE ? 0 : 7;
+    int rookStartFile, rookEndFile;
+    enum CSC_MoveType mt = CSC_GetMoveType(m);
+    CSC_Piece sp = b->squares[e];
+
+    dirty->n = 0;
+
+    /* Null moves don't change anything. */
+    if (m == CSC_NO_MOVE) return;
+
+    CSC_SetPieceType(&sp, bs->lastMovePieceType);
+    AddDirtyPiece(dirty, sp, s, false);
+
+    if (bs->lastMoveCapture)
+    {
+        AddDirtyPiece(
+            dirty,
+            bs->lastMoveCapture,
+            mt == CSC_ENPASSENT
+                ? e + (p == CSC_WHITE ? -CSC_FILE_NB : CSC_FILE_NB)
+                : e,
+            false);
+    }
+
+    if (mt & CSC_CASTLE)
+    {
+        rookStartFile = mt == CSC_KINGCASTLE ? 7 : 0;
+        rookEndFile = mt == CSC_KINGCASTLE ? 5 : 3;
+
+        AddDirtyPiece(
+            dirty,
+            b->squares[8*castleRank + rookEndFile],
+            8*castleRank + rookStartFile,
+            false);
+
+        AddDirtyPiece(
+            dirty,
+            b->squares[8*castleRank + rookEndFile],
+            8*castleRank + rookEndFile,
+            true);
+    }
+
+    AddDirtyPiece(dirty, b->squares[e], e, true);
+}
+
+/* The hash and list of changes are updated if they're given. */
+CSC_Piece RemovePiece(
+    struct CSC_Board* b,
+    int loc,
+    CSC_Hash* hash,
+    struct CSC_DirtyPieces* dirty)
 {
     CSC_Piece pc = b->squares[loc];
     int p = CSC_GetPieceColour(pc);
@@ -101,10 +229,17 @@ CSC_Piece RemovePiece(struct CSC_Board* b, int loc, CSC_Hash* hash)
         *hash ^= keys.pieceSquare[p][pt][loc];
     }
 
+    if (dirty != NULL) AddDirtyPiece(dirty, pc, loc, false);
+
     return pc;
 }
 
-void AddPiece(struct CSC_Board* b, int loc, CSC_Piece pc, CSC_Hash* hash)
+void AddPiece(
+    struct CSC_Board* b,
+    int loc,
+    CSC_Piece pc,
+    CSC_Hash* hash,
+    struct CSC_DirtyPieces* dirty)
 {
     int p = CSC_GetPieceColour(pc);
     enum CSC_PieceType pt = CSC_GetPieceType(pc);
@@ -118,10 +253,101 @@ void AddPiece(struct CSC_Board* b, int loc, CSC_Piece pc, CSC_Hash* hash)
     {
         *hash ^= keys.pieceSquare[p][pt][loc];
     }
+
+    if (dirty != NULL) AddDirtyPiece(dirty, pc, loc, true);
+}
+
+/* The en-passent file is only included in the hash when the player has a legal
+   en-passent capture, so that positions which only differ by an unusable
+   en-passent square share a hash. */
+bool CanCaptureEnPassent(struct CSC_Board* b, int ep, int p)
+{
+    return PiecesCanCaptureEnPassent(
+        b->pieces,
+        b->all[CSC_WHITE] | b->all[CSC_BLACK],
+        ep,
+        p);
+}
+
+bool PiecesCanCaptureEnPassent(
+    CSC_Bitboard pieces[7][2],
+    CSC_Bitboard occ,
+    int ep,
+    int p)
+{
+    CSC_Bitboard pawns, captured, after;
+    int king;
+
+    if (ep == CSC_BAD_LOC) return false;
+
+    pawns = CSC_PawnAttacks[1-p][ep] & pieces[CSC_PAWN][p];
+    if (!pawns) return false;
+
+    /* Boards without a king are allowed (e.g. for setting up positions). */
+    if (!pieces[CSC_KING][p]) return true;
+
+    king = CSC_LSB(pieces[CSC_KING][p]);
+    captured = (CSC_Bitboard)1
+        << (ep + (p == CSC_WHITE ? -CSC_FILE_NB : CSC_FILE_NB));
+
+    /* The capture is legal if the king isn't attacked afterwards by anything
+       other than the captured pawn. */
+    if (CSC_KnightAttacks[king] & pieces[CSC_KNIGHT][1-p]) return false;
+    if (CSC_PawnAttacks[p][king] & pieces[CSC_PAWN][1-p] & ~captured)
+        return false;
+
+    while (pawns)
+    {
+        after = (occ ^ captured ^ (pawns & -pawns)) | ((CSC_Bitboard)1 << ep);
+        CSC_PopLSB(&pawns);
+
+        if (!(CSC_RookAttacks(king, after)
+                & (pieces[CSC_ROOK][1-p] | pieces[CSC_QUEEN][1-p]))
+         && !(CSC_BishopAttacks(king, after)
+                & (pieces[CSC_BISHOP][1-p] | pieces[CSC_QUEEN][1-p])))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* The rights are lost when the king or a rook moves, or when a rook is
+   captured on its starting square. */
+uint8_t CastlingAfterMove(
+    uint8_t castling,
+    int p,
+    enum CSC_PieceType pt,
+    int s,
+    int e,
+    CSC_Piece cap)
+{
+    int kingRookLoc, queenRookLoc;
+
+    if (pt == CSC_KING)
+    {
+        castling &= ~(CASTLE_KINGSIDE(p) | CASTLE_QUEENSIDE(p));
+    }
+    else if (pt == CSC_ROOK)
+    {
+        kingRookLoc = p == CSC_WHITE ? 7 : 63;
+        queenRookLoc = p == CSC_WHITE ? 0 : 56;
+        if (s == kingRookLoc) castling &= ~CASTLE_KINGSIDE(p);
+        if (s == queenRookLoc) castling &= ~CASTLE_QUEENSIDE(p);
+    }
+
+    if (cap && CSC_GetPieceType(cap) == CSC_ROOK)
+    {
+        kingRookLoc = p == CSC_WHITE ? 63 : 7;
+        queenRookLoc = p == CSC_WHITE ? 56 : 0;
+        if (e == kingRookLoc) castling &= ~CASTLE_KINGSIDE(1-p);
+        if (e == queenRookLoc) castling &= ~CASTLE_QUEENSIDE(1-p);
+    }
+
+    return castling;
 }
 
-/* TODO: The hash needs to be updated when an enpassent location becomes
-   unavailable. */
 void CSC_MakeMove(struct CSC_Board* b, CSC_Move m)
 {
     int p = b->player;
@@ -131,28 +357,34 @@ void CSC_MakeMove(struct CSC_Board* b, CSC_Move m)
     int capLoc = e;
     int rookStartFile, rookEndFile;
     int castleRank;
-    int kingRookLoc, queenRookLoc;
-    int plies50Move;
+    int plies50Move, pliesFromNull;
+    uint8_t castling;
     CSC_Piece sp, cap, rook;
-    CSC_Hash hash;
-    enum CSC_PieceType pt;
+    CSC_Hash hash, pawnHash;
+    uint32_t materialKey;
+    enum CSC_PieceType pt, promo, capType;
     enum CSC_MoveType mt;
-    struct CSC_CastlingRights ourCastlingRights, theirCastlingRights;
     struct BoardState* next, *bs;
+    struct DerivedState* derived;
+    struct CSC_DirtyPieces dirty;
 
     assert(b != NULL);
     assert(b->states != NULL);
 
     bs = Top((struct StateStack*)b->states);
+    dirty.n = 0;
 
     hash = bs->hash;
-    sp = RemovePiece(b, s, &hash);
+    if (CanCaptureEnPassent(b, bs->enPassentIndex, p))
+        hash ^= keys.enpassentFile[bs->enPassentIndex % CSC_FILE_NB];
+
+    sp = RemovePiece(b, s, &hash, &dirty);
     cap = b->squares[e];
 
     pt = CSC_GetPieceType(sp);
     mt = CSC_GetMoveType(m);
 
-    if (cap && mt != CSC_ENPASSENT) RemovePiece(b, e, &hash);
+    if (cap && mt != CSC_ENPASSENT) RemovePiece(b, e, &hash, &dirty);
 
     if (mt == CSC_ENPASSENT)
     {
@@ -160,7 +392,7 @@ void CSC_MakeMove(struct CSC_Board* b, CSC_Move m)
 
         capLoc = e + (p == CSC_WHITE ? -CSC_FILE_NB : CSC_FILE_NB);
         cap = b->squares[capLoc];
-        RemovePiece(b, capLoc, &hash);
+        RemovePiece(b, capLoc, &hash, &dirty);
     }
     else if (mt == CSC_PROMOTION)
     {
@@ -178,48 +410,58 @@ void CSC_MakeMove(struct CSC_Board* b, CSC_Move m)
         assert(CSC_GetPieceType(rook) == CSC_ROOK);
         assert(CSC_GetPieceColour(rook) == p);
 
-        RemovePiece(b, 8*castleRank + rookStartFile, &hash);
-        AddPiece(b, 8*castleRank + rookEndFile, rook, &hash);
-
-        hash ^= mt == CSC_KINGCASTLE
-            ? keys.castling[b->player][0]
-            : keys.castling[b->player][1];
+        RemovePiece(b, 8*castleRank + rookStartFile, &hash, &dirty);
+        AddPiece(b, 8*castleRank + rookEndFile, rook, &hash, &dirty);
     }
 
     /* Add the piece back now that the promotion has been applied. */
-    AddPiece(b, e, sp, &hash);
+    AddPiece(b, e, sp, &hash, &dirty);
 
-    ourCastlingRights = bs->castlingRights[p];
-    if (pt == CSC_KING)
-    {
-        ourCastlingRights.kingSide = false;
-        ourCastlingRights.queenSide = false;
-    }
-    else if (pt == CSC_ROOK)
+    /* Update the pawn hash and material key (the piece counts are those after
+       the move). */
+    pawnHash = bs->pawnHash;
+    materialKey = bs->materialKey;
+
+    if (pt == CSC_PAWN)
     {
-        kingRookLoc = p == CSC_WHITE ? 7 : 63;
-        queenRookLoc = p == CSC_WHITE ? 0 : 56;
-        ourCastlingRights.kingSide &= (s != kingRookLoc);
-        ourCastlingRights.queenSide &= (s != queenRookLoc);
+        pawnHash ^= keys.pieceSquare[p][CSC_PAWN][s];
+        if (mt == CSC_PROMOTION)
+        {
+            promo = CSC_GetMovePromotion(m);
+            materialKey ^= MaterialKey(
+                p, CSC_PAWN, CSC_PopCount(b->pieces[CSC_PAWN][p]));
+            materialKey ^= MaterialKey(
+                p, promo, CSC_PopCount(b->pieces[promo][p]) - 1);
+        }
+        else
+        {
+            pawnHash ^= keys.pieceSquare[p][CSC_PAWN][e];
+        }
     }
 
-    theirCastlingRights = bs->castlingRights[1-p];
-    if (cap && CSC_GetPieceType(cap) == CSC_ROOK)
+    if (cap)
     {
-        kingRookLoc = p == CSC_WHITE ? 63 : 7;
-        queenRookLoc = p == CSC_WHITE ? 56 : 0;
-        theirCastlingRights.kingSide &= (e != kingRookLoc);
-        theirCastlingRights.queenSide &= (e != queenRookLoc);
+        capType = CSC_GetPieceType(cap);
+        if (capType == CSC_PAWN)
+            pawnHash ^= keys.pieceSquare[1-p][CSC_PAWN][capLoc];
+
+        materialKey ^= MaterialKey(
+            1-p, capType, CSC_PopCount(b->pieces[capType][1-p]));
     }
 
+    castling = CastlingAfterMove(bs->castling, p, pt, s, e, cap);
+    hash ^= keys.castlingRights[bs->castling ^ castling];
+
     if (mt == CSC_TWOSPACE)
     {
         ep = e + (p == CSC_WHITE ? -8 : 8);
-        hash ^= keys.enpassentFile[e % CSC_FILE_NB];
+        if (CanCaptureEnPassent(b, ep, 1-p))
+            hash ^= keys.enpassentFile[e % CSC_FILE_NB];
     }
 
-    /* Fill in the next board state. */
+    /* Fill in the next board state (the stack might move when it's pushed). */
     plies50Move = bs->plies50Move + 1;
+    pliesFromNull = bs->pliesFromNull + 1;
 
     next = Push((struct StateStack*)b->states);
     next->lastMove = m;
@@ -227,14 +469,33 @@ void CSC_MakeMove(struct CSC_Board* b, CSC_Move m)
     next->lastMovePieceType = pt;
     next->enPassentIndex = ep;
     next->plies50Move = plies50Move;
-    next->castlingRights[p] = ourCastlingRights;
-    next->castlingRights[1-p] = theirCastlingRights;
+    next->pliesFromNull = pliesFromNull;
+    next->castling = castling;
     next->hash = hash;
+    next->pawnHash = pawnHash;
+    next->materialKey = materialKey;
 
     if (cap || pt == CSC_PAWN) next->plies50Move = 0;
 
     b->player = 1 - p;
     next->hash ^= keys.side;
+
+    UpdateCheckInfo(b, TopChecks((struct StateStack*)b->states));
+
+    derived = TopDerived((struct StateStack*)b->states);
+    derived->checkInfoValid = false;
+    derived->dirtyValid = true;
+    derived->dirty = dirty;
+}
+
+/* Only the top of the stack has a derived state, so after undoing a move it's
+   worked out again when it's next needed. */
+void UndoDerivedState(struct CSC_Board* b)
+{
+    struct DerivedState* derived = TopDerived((struct StateStack*)b->states);
+
+    derived->checkInfoValid = false;
+    derived->dirtyValid = false;
 }
 
 void CSC_UndoMove(struct CSC_Board* b)
@@ -260,12 +521,12 @@ void CSC_UndoMove(struct CSC_Board* b)
     e = CSC_GetMoveEnd(m);
 
     /* Move the pieces back. */
-    pc = RemovePiece(b, e, NULL);
+    pc = RemovePiece(b, e, NULL, NULL);
 
     mt = CSC_GetMoveType(m);
     if (mt == CSC_PROMOTION) CSC_SetPieceType(&pc, CSC_PAWN);
 
-    AddPiece(b, s, pc, NULL);
+    AddPiece(b, s, pc, NULL, NULL);
 
     if (old->lastMoveCapture)
     {
@@ -273,7 +534,7 @@ void CSC_UndoMove(struct CSC_Board* b)
         if (mt == CSC_ENPASSENT)
             capLoc = e + (p == CSC_WHITE ? -CSC_FILE_NB : CSC_FILE_NB);
 
-        AddPiece(b, capLoc, old->lastMoveCapture, NULL);
+        AddPiece(b, capLoc, old->lastMoveCapture, NULL, NULL);
     }
 
     if (mt & CSC_CASTLE)
@@ -283,85 +544,254 @@ void CSC_UndoMove(struct CSC_Board* b)
         rookEndFile = mt == CSC_KINGCASTLE ? 7 : 0;
         rookRank = p == CSC_WHITE ? 0 : 7;
 
-        rook = RemovePiece(b, 8*rookRank + rookStartFile, NULL);
-        AddPiece(b, 8*rookRank + rookEndFile, rook, NULL);
+        rook = RemovePiece(b, 8*rookRank + rookStartFile, NULL, NULL);
+        AddPiece(b, 8*rookRank + rookEndFile, rook, NULL, NULL);
 
         assert(CSC_GetPieceType(rook) == CSC_ROOK);
         assert(CSC_GetPieceColour(rook) == p);
     }
+
+    UndoDerivedState(b);
+}
+
+void CSC_MakeNullMove(struct CSC_Board* b)
+{
+    struct BoardState* next, *bs;
+    struct DerivedState* derived;
+    CSC_Hash hash, pawnHash;
+    uint32_t materialKey;
+    int plies50Move;
+    uint8_t castling;
+
+    assert(b != NULL);
+    assert(b->states != NULL);
+    assert(!CSC_InCheck(b));
+
+    bs = Top((struct StateStack*)b->states);
+
+    hash = bs->hash ^ keys.side;
+    if (CanCaptureEnPassent(b, bs->enPassentIndex, b->player))
+        hash ^= keys.enpassentFile[bs->enPassentIndex % CSC_FILE_NB];
+
+    /* Pushing can move the stack, so copy what's needed from the top first. */
+    plies50Move = bs->plies50Move + 1;
+    castling = bs->castling;
+    pawnHash = bs->pawnHash;
+    materialKey = bs->materialKey;
+
+    next = Push((struct StateStack*)b->states);
+    next->hash = hash;
+    next->lastMove = CSC_NO_MOVE;
+    next->lastMoveCapture = 0;
+    next->lastMovePieceType = CSC_NONE;
+    next->enPassentIndex = CSC_BAD_LOC;
+    next->plies50Move = plies50Move;
+    next->pliesFromNull = 0;
+    next->castling = castling;
+    next->pawnHash = pawnHash;
+    next->materialKey = materialKey;
+
+    b->player = 1 - b->player;
+
+    UpdateCheckInfo(b, TopChecks((struct StateStack*)b->states));
+
+    derived = TopDerived((struct StateStack*)b->states);
+    derived->checkInfoValid = false;
+    derived->dirtyValid = true;
+    derived->dirty.n = 0;
+}
+
+void CSC_UndoNullMove(struct CSC_Board* b)
+{
+    assert(b != NULL);
+    assert(b->states != NULL);
+    assert(Top((struct StateStack*)b->states)->lastMove == CSC_NO_MOVE);
+
+    Pop((struct StateStack*)b->states);
+    b->player = 1 - b->player;
+
+    UndoDerivedState(b);
 }
 
 /* There's some duplication of both MakeMove and UndoMove in this function. */
 /* Essentially we need to partially make the move in order to check that it
    is legal (i.e. the king doesn't end in check). */
-bool CSC_IsLegal(struct CSC_Board* b, CSC_Move m)
+bool IsLegalByProbe(struct CSC_Board* b, CSC_Move m)
 {
     CSC_Piece sp, cap;
     enum CSC_MoveType mt;
     int p, s, e, capLoc;
     bool legal;
 
-    assert(b != NULL);
-    assert(b->states != NULL);
-
     p = b->player;
     s = CSC_GetMoveStart(m);
     e = CSC_GetMoveEnd(m);
 
-    sp = RemovePiece(b, s, NULL);
+    sp = RemovePiece(b, s, NULL, NULL);
     cap = b->squares[e];
 
     mt = CSC_GetMoveType(m);
 
-    if (cap && mt != CSC_ENPASSENT) RemovePiece(b, e, NULL);
+    if (cap && mt != CSC_ENPASSENT) RemovePiece(b, e, NULL, NULL);
 
     capLoc = e;
     if (mt == CSC_ENPASSENT)
     {
         capLoc = e + (p == CSC_WHITE ? -CSC_FILE_NB : CSC_FILE_NB);
-        cap = RemovePiece(b, capLoc, NULL);
+        cap = RemovePiece(b, capLoc, NULL, NULL);
     }
 
-    AddPiece(b, e, sp, NULL);
+    AddPiece(b, e, sp, NULL, NULL);
 
     legal = !CSC_IsAttacked(b, CSC_LSB(b->pieces[CSC_KING][p]));
 
     /* Undo the previously made board changes. */
-    RemovePiece(b, e, NULL);
+    RemovePiece(b, e, NULL, NULL);
 
-    AddPiece(b, s, sp, NULL);
+    AddPiece(b, s, sp, NULL, NULL);
 
     if (cap)
     {
-        AddPiece(b, capLoc, cap, NULL);
+        AddPiece(b, capLoc, cap, NULL, NULL);
     }
 
     return legal;
 }
 
+bool CSC_IsLegal(struct CSC_Board* b, CSC_Move m)
+{
+    struct CheckState* cs;
+    CSC_Bitboard occ;
+    int p, s, e, king;
+
+    assert(b != NULL);
+    assert(b->states != NULL);
+
+    /* En-passent removes two pieces from the lines to the king, so it's
+       simplest to try it. */
+    if (CSC_GetMoveType(m) == CSC_ENPASSENT) return IsLegalByProbe(b, m);
+
+    cs = TopChecks((struct StateStack*)b->states);
+    p = b->player;
+    s = CSC_GetMoveStart(m);
+    e = CSC_GetMoveEnd(m);
+    king = CSC_LSB(b->pieces[CSC_KING][p]);
+
+    /* The king must not move to an attacked square (ignoring the king itself
+       so that it can't step back along the line of a checking slider). */
+    if (s == king)
+    {
+        occ = (b->all[CSC_WHITE] | b->all[CSC_BLACK]) ^ ((CSC_Bitboard)1 << s);
+        return !AttackersOf(b, e, occ, 1-p);
+    }
+
+    /* Other pieces must capture or block a single checker. */
+    if (cs->checkers)
+    {
+        if (cs->checkers & (cs->checkers - 1)) return false;
+        if (!CSC_Test(
+            CSC_Between[king][CSC_LSB(cs->checkers)] | cs->checkers, e))
+        {
+            return false;
+        }
+    }
+
+    /* Pinned pieces must stay on the line to the king. */
+    return !CSC_Test(cs->blockers, s) || CSC_Test(CSC_Line[king][s], e);
+}
+
 bool CSC_IsDrawn(struct CSC_Board* b)
 {
-    struct BoardState* bs = Top((struct StateStack*)b->states);
-    CSC_Hash latestHash;
-    int hashCount = 1;
+    struct StateStack* stack = (struct StateStack*)b->states;
+    struct BoardState* bs = Top(stack);
+    int plies, maxPlies, hashCount = 1;
 
     if (bs->plies50Move >= 100) return true;
 
     /* Examine hashes to determine whether there has been a draw by repetition. */
-    /* When checking these we can stop when we find the first irreversible move
-       i.e. a pawn move or a capture. */
-    latestHash = bs->hash;
-    bs = bs->previousState;
-    while (bs != NULL
-        && !bs->lastMoveCapture
-        && bs->lastMovePieceType != CSC_PAWN
-        && hashCount < 3)
+    /* A repetition must have the same player to move and can't be before the
+       last irreversible move (i.e. a pawn move or a capture) or null move. The
+       repetition counters rule out most positions without looking back. */
+    maxPlies = bs->plies50Move < bs->pliesFromNull
+        ? bs->plies50Move
+        : bs->pliesFromNull;
+
+    if (maxPlies < 4 || RepetitionCount(stack, bs->hash) < 2) return false;
+
+    for (plies = 4; plies <= maxPlies; plies += 2)
     {
-        hashCount += bs->hash == latestHash;
-        bs = bs->previousState;
+        if (stack->data[stack->head - plies].hash == bs->hash
+            && ++hashCount >= 3)
+        {
+            return true;
+        }
     }
 
-    return hashCount >= 3;
+    return false;
+}
+
+/* Check whether the state at the given index repeats an earlier state. */
+bool HasOccurredBefore(struct StateStack* stack, size_t index)
+{
+    struct BoardState* bs = &stack->data[index];
+    int plies, maxPlies;
+
+    maxPlies = bs->plies50Move < bs->pliesFromNull
+        ? bs->plies50Move
+        : bs->pliesFromNull;
+
+    for (plies = 4; plies <= maxPlies; plies += 2)
+    {
+        if (stack->data[index - plies].hash == bs->hash) return true;
+    }
+
+    return false;
+}
+
+/* The difference between the current hash and an earlier hash (with the other
+   player to move) is looked up in the table of reversible moves. If there's a
+   match and nothing is in the way then the earlier position can be reached in
+   one move. */
+bool CSC_HasUpcomingRepetition(struct CSC_Board* b, int ply)
+{
+    struct StateStack* stack = (struct StateStack*)b->states;
+    struct BoardState* bs = Top(stack);
+    CSC_Bitboard occ = b->all[CSC_WHITE] | b->all[CSC_BLACK];
+    CSC_Hash moveKey;
+    CSC_Move m;
+    CSC_Piece pc;
+    int plies, maxPlies, i, s, e;
+
+    maxPlies = bs->plies50Move < bs->pliesFromNull
+        ? bs->plies50Move
+        : bs->pliesFromNull;
+
+    for (plies = 3; plies <= maxPlies; plies += 2)
+    {
+        moveKey = bs->hash ^ stack->data[stack->head - plies].hash;
+
+        i = CuckooH1(moveKey);
+        if (cuckoo.keys[i] != moveKey)
+        {
+            i = CuckooH2(moveKey);
+            if (cuckoo.keys[i] != moveKey) continue;
+        }
+
+        m = cuckoo.moves[i];
+        s = CSC_GetMoveStart(m);
+        e = CSC_GetMoveEnd(m);
+
+        if (CSC_Between[s][e] & occ) continue;
+
+        /* The piece could be on either square. */
+        pc = b->squares[s] ? b->squares[s] : b->squares[e];
+        if (CSC_GetPieceColour(pc) != b->player) continue;
+
+        if (ply > plies || HasOccurredBefore(stack, stack->head - plies))
+            return true;
+    }
+
+    return false;
 }
 
 void CSC_FreeBoard(struct CSC_Board* b)
@@ -406,126 +836,227 @@ void CSC_PrintBoard(struct CSC_Board* b)
     }
 }
 
-bool IsOrthAttacked(
-    struct CSC_Board* b,
-    int loc,
-    CSC_Bitboard targets,
-    CSC_Bitboard (*rays)[8])
+bool CSC_IsAttacked(struct CSC_Board* b, int loc)
 {
+    int p = b->player;
+    int e = 1-p;
     CSC_Bitboard all = b->all[CSC_WHITE] | b->all[CSC_BLACK];
-    CSC_Bitboard ray, attackers;
+    CSC_Bitboard targets, bit, pawns, attackers;
 
-    ray = rays[loc][CSC_NORTH];
-    attackers = ray & targets;
-    if (attackers)
-    {
-        ray ^= (attackers | rays[CSC_LSB(attackers)][CSC_NORTH]);
-        if (!(ray & all)) return true;
-    }
+    /* Check steppers. */
+    if (CSC_KingAttacks[loc] & b->pieces[CSC_KING][e]) return true;
+    if (CSC_KnightAttacks[loc] & b->pieces[CSC_KNIGHT][e]) return true;
 
-    ray = rays[loc][CSC_EAST];
-    attackers = ray & targets;
-    if (attackers)
+    /* Check orthogonal rays. */
+    targets = b->pieces[CSC_ROOK][e] | b->pieces[CSC_QUEEN][e];
+    if (CSC_RayAttacksAll[loc][CSC_ORTHOGONAL] & targets)
     {
-        ray ^= (attackers | rays[CSC_LSB(attackers)][CSC_EAST]);
-        if (!(ray & all)) return true;
+        if (CSC_RookAttacks(loc, all) & targets) return true;
     }
 
-    ray = rays[loc][CSC_SOUTH];
-    attackers = ray & targets;
-    if (attackers)
+    /* Check diagonal rays. */
+    targets = b->pieces[CSC_BISHOP][e] | b->pieces[CSC_QUEEN][e];
+    if (CSC_RayAttacksAll[loc][CSC_DIAGONAL] & targets)
     {
-        ray ^= (attackers | rays[CSC_MSB(attackers)][CSC_SOUTH]);
-        if (!(ray & all)) return true;
+        if (CSC_BishopAttacks(loc, all) & targets) return true;
     }
 
-    ray = rays[loc][CSC_WEST];
-    attackers = ray & targets;
-    if (attackers)
-    {
-        ray ^= (attackers | rays[CSC_MSB(attackers)][CSC_WEST]);
-        if (!(ray & all)) return true;
-    }
+    /* Check pawns. */
+    bit = (CSC_Bitboard)1 << loc;
+    pawns = b->pieces[CSC_PAWN][e];
+
+    attackers = 0;
+    if (!(bit & CSC_Files[0])) attackers |= e == CSC_WHITE ? bit >> 9 : bit << 7;
+    if (!(bit & CSC_Files[7])) attackers |= e == CSC_WHITE ? bit >> 7 : bit << 9;
+    if (attackers & pawns) return true;
 
     return false;
 }
 
-bool IsDiagAttacked(
+CSC_Bitboard AttackersOf(
     struct CSC_Board* b,
     int loc,
-    CSC_Bitboard targets,
-    CSC_Bitboard (*rays)[8])
+    CSC_Bitboard occ,
+    int p)
 {
-    CSC_Bitboard all = b->all[CSC_WHITE] | b->all[CSC_BLACK];
-    CSC_Bitboard ray, attackers;
+    return (CSC_PawnAttacks[1-p][loc] & b->pieces[CSC_PAWN][p])
+         | (CSC_KnightAttacks[loc] & b->pieces[CSC_KNIGHT][p])
+         | (CSC_KingAttacks[loc] & b->pieces[CSC_KING][p])
+         | (CSC_RookAttacks(loc, occ)
+            & (b->pieces[CSC_ROOK][p] | b->pieces[CSC_QUEEN][p]))
+         | (CSC_BishopAttacks(loc, occ)
+            & (b->pieces[CSC_BISHOP][p] | b->pieces[CSC_QUEEN][p]));
+}
 
-    ray = rays[loc][CSC_NORTHEAST];
-    attackers = ray & targets;
-    if (attackers)
-    {
-        ray ^= (attackers | rays[CSC_LSB(attackers)][CSC_NORTHEAST]);
-        if (!(ray & all)) return true;
-    }
+CSC_Bitboard CSC_AttackersTo(
+    struct CSC_Board* b,
+    int loc,
+    CSC_Bitboard occ)
+{
+    return AttackersOf(b, loc, occ, CSC_WHITE)
+         | AttackersOf(b, loc, occ, CSC_BLACK);
+}
 
-    ray = rays[loc][CSC_NORTHWEST];
-    attackers = ray & targets;
-    if (attackers)
-    {
-        ray ^= (attackers | rays[CSC_LSB(attackers)][CSC_NORTHWEST]);
-        if (!(ray & all)) return true;
-    }
+void CSC_ReserveHistory(struct CSC_Board* b, int plies)
+{
+    struct StateStack* stack = (struct StateStack*)b->states;
+    Reserve(stack, stack->head + 1 + plies);
+}
 
-    ray = rays[loc][CSC_SOUTHEAST];
-    attackers = ray & targets;
-    if (attackers)
-    {
-        ray ^= (attackers | rays[CSC_MSB(attackers)][CSC_SOUTHEAST]);
-        if (!(ray & all)) return true;
-    }
+bool CSC_InCheck(struct CSC_Board* b)
+{
+    struct CheckState* cs = TopChecks((struct StateStack*)b->states);
+    return cs->checkers != 0;
+}
+
+CSC_Bitboard CSC_GetCheckers(struct CSC_Board* b)
+{
+    struct CheckState* cs = TopChecks((struct StateStack*)b->states);
+    return cs->checkers;
+}
 
-    ray = rays[loc][CSC_SOUTHWEST];
-    attackers = ray & targets;
-    if (attackers)
+CSC_Bitboard KingBlockers(struct CSC_Board* b, int p)
+{
+    int king = CSC_LSB(b->pieces[CSC_KING][p]);
+    CSC_Bitboard occ = b->all[CSC_WHITE] | b->all[CSC_BLACK];
+    CSC_Bitboard snipers, between, blockers = 0;
+
+    /* Find the enemy sliders which would attack the king on an empty board. */
+    snipers = (CSC_RayAttacksAll[king][CSC_ORTHOGONAL]
+            & (b->pieces[CSC_ROOK][1-p] | b->pieces[CSC_QUEEN][1-p]))
+            | (CSC_RayAttacksAll[king][CSC_DIAGONAL]
+            & (b->pieces[CSC_BISHOP][1-p] | b->pieces[CSC_QUEEN][1-p]));
+
+    while (snipers)
     {
-        ray ^= (attackers | rays[CSC_MSB(attackers)][CSC_SOUTHWEST]);
-        if (!(ray & all)) return true;
+        between = CSC_Between[king][CSC_PopLSB(&snipers)] & occ;
+        if (between && !(between & (between - 1))) blockers |= between;
     }
 
-    return false;
+    return blockers;
 }
 
-bool CSC_IsAttacked(struct CSC_Board* b, int loc)
+void UpdateCheckInfo(struct CSC_Board* b, struct CheckState* cs)
 {
     int p = b->player;
-    int e = 1-p;
-    CSC_Bitboard targets, bit, pawns, attackers;
+    int king;
+    CSC_Bitboard occ = b->all[CSC_WHITE] | b->all[CSC_BLACK];
+    CSC_Bitboard snipers, between, sniper;
 
-    /* Check steppers. */
-    if (CSC_KingAttacks[loc] & b->pieces[CSC_KING][e]) return true;
-    if (CSC_KnightAttacks[loc] & b->pieces[CSC_KNIGHT][e]) return true;
+    cs->checkers = 0;
+    cs->blockers = 0;
 
-    /* Check orthogonal rays. */
-    targets = b->pieces[CSC_ROOK][e] | b->pieces[CSC_QUEEN][e];
-    if (CSC_RayAttacksAll[loc][CSC_ORTHOGONAL] & targets)
-    {
-        if (IsOrthAttacked(b, loc, targets, CSC_RayAttacks)) return true;
-    }
+    /* Boards without a king are allowed (e.g. for setting up positions). */
+    if (!b->pieces[CSC_KING][p]) return;
 
-    /* Check diagonal rays. */
-    targets = b->pieces[CSC_BISHOP][e] | b->pieces[CSC_QUEEN][e];
-    if (CSC_RayAttacksAll[loc][CSC_DIAGONAL] & targets)
+    king = CSC_LSB(b->pieces[CSC_KING][p]);
+
+    cs->checkers = (CSC_PawnAttacks[p][king] & b->pieces[CSC_PAWN][1-p])
+        | (CSC_KnightAttacks[king] & b->pieces[CSC_KNIGHT][1-p]);
+
+    /* Each enemy slider on a line to the king is either checking it or is
+       blocked, and the blockers are only of interest if there's just one. */
+    snipers = (CSC_RayAttacksAll[king][CSC_ORTHOGONAL]
+            & (b->pieces[CSC_ROOK][1-p] | b->pieces[CSC_QUEEN][1-p]))
+            | (CSC_RayAttacksAll[king][CSC_DIAGONAL]
+            & (b->pieces[CSC_BISHOP][1-p] | b->pieces[CSC_QUEEN][1-p]));
+
+    while (snipers)
     {
-        if (IsDiagAttacked(b, loc, targets, CSC_RayAttacks)) return true;
+        sniper = snipers & -snipers;
+        between = CSC_Between[king][CSC_PopLSB(&snipers)] & occ;
+        if (!between) cs->checkers |= sniper;
+        else if (!(between & (between - 1))) cs->blockers |= between;
     }
+}
 
-    /* Check pawns. */
-    bit = (CSC_Bitboard)1 << loc;
-    pawns = b->pieces[CSC_PAWN][e];
+struct CheckInfo* GetCheckInfo(struct CSC_Board* b)
+{
+    struct DerivedState* ds = TopDerived((struct StateStack*)b->states);
+    struct CheckInfo* ci = &ds->checkInfo;
+    int p = b->player;
+    CSC_Bitboard occ = b->all[CSC_WHITE] | b->all[CSC_BLACK];
 
-    attackers = 0;
-    if (!(bit & CSC_Files[0])) attackers |= e == CSC_WHITE ? bit >> 9 : bit << 7;
-    if (!(bit & CSC_Files[7])) attackers |= e == CSC_WHITE ? bit >> 7 : bit << 9;
-    if (attackers & pawns) return true;
+    if (ds->checkInfoValid) return ci;
 
-    return false;
+    ci->enemyKing = CSC_LSB(b->pieces[CSC_KING][1-p]);
+    ci->discoverers = KingBlockers(b, 1-p) & b->all[p];
+
+    ci->squares[CSC_NONE] = 0;
+    ci->squares[CSC_PAWN] = CSC_PawnAttacks[1-p][ci->enemyKing];
+    ci->squares[CSC_KNIGHT] = CSC_KnightAttacks[ci->enemyKing];
+    ci->squares[CSC_BISHOP] = CSC_BishopAttacks(ci->enemyKing, occ);
+    ci->squares[CSC_ROOK] = CSC_RookAttacks(ci->enemyKing, occ);
+    ci->squares[CSC_QUEEN] = ci->squares[CSC_BISHOP] | ci->squares[CSC_ROOK];
+    ci->squares[CSC_KING] = 0;
+
+    ds->checkInfoValid = true;
+
+    return ci;
+}
+
+bool CSC_GivesCheck(struct CSC_Board* b, CSC_Move m)
+{
+    struct CheckInfo* ci = GetCheckInfo(b);
+    int p = b->player;
+    int s = CSC_GetMoveStart(m);
+    int e = CSC_GetMoveEnd(m);
+    int capLoc, rookStart, rookEnd;
+    enum CSC_MoveType mt = CSC_GetMoveType(m);
+    CSC_Bitboard occ = b->all[CSC_WHITE] | b->all[CSC_BLACK];
+    CSC_Bitboard attacks;
+
+    /* Check for a discovered check (castling never moves the king off the
+       line to the enemy king since it stays on its rank). */
+    if (CSC_Test(ci->discoverers, s) && !CSC_Test(CSC_Line[ci->enemyKing][s], e))
+    {
+        return true;
+    }
+
+    switch (mt)
+    {
+        case CSC_PROMOTION:
+            /* The promoted piece can attack through its starting square. */
+            occ ^= (CSC_Bitboard)1 << s;
+            switch (CSC_GetMovePromotion(m))
+            {
+                case CSC_KNIGHT: attacks = CSC_KnightAttacks[e]; break;
+                case CSC_BISHOP: attacks = CSC_BishopAttacks(e, occ); break;
+                case CSC_ROOK: attacks = CSC_RookAttacks(e, occ); break;
+                default:
+                    attacks = CSC_BishopAttacks(e, occ) | CSC_RookAttacks(e, occ);
+            }
+
+            return CSC_Test(attacks, ci->enemyKing);
+
+        case CSC_ENPASSENT:
+            if (CSC_Test(ci->squares[CSC_PAWN], e)) return true;
+
+            /* Removing the captured pawn can also discover a check. */
+            capLoc = e + (p == CSC_WHITE ? -CSC_FILE_NB : CSC_FILE_NB);
+            occ ^= ((CSC_Bitboard)1 << s)
+                 | ((CSC_Bitboard)1 << capLoc)
+                 | ((CSC_Bitboard)1 << e);
+
+            return (CSC_RookAttacks(ci->enemyKing, occ)
+                    & (b->pieces[CSC_ROOK][p] | b->pieces[CSC_QUEEN][p]))
+                || (CSC_BishopAttacks(ci->enemyKing, occ)
+                    & (b->pieces[CSC_BISHOP][p] | b->pieces[CSC_QUEEN][p]));
+
+        case CSC_KINGCASTLE:
+        case CSC_QUEENCASTLE:
+            rookStart = mt == CSC_KINGCASTLE ? s+3 : s-4;
+            rookEnd = mt == CSC_KINGCASTLE ? s+1 : s-1;
+            occ ^= ((CSC_Bitboard)1 << s)
+                 | ((CSC_Bitboard)1 << e)
+                 | ((CSC_Bitboard)1 << rookStart)
+                 | ((CSC_Bitboard)1 << rookEnd);
+
+            return CSC_Test(CSC_RookAttacks(rookEnd, occ), ci->enemyKing);
+
+        default:
+            return CSC_Test(
+                ci->squares[CSC_GetPieceType(b->squares[s])],
+                e);
+    }
 }
@@ -3,9 +3,56 @@
 
 #include "chessic.h"
 
+struct BoardState;
+struct CheckState;
+struct DerivedState;
+struct CheckInfo;
+
 struct CSC_Board* CreateBoardEmpty();
 
 /* Get the colour and piece type at the specified location. */
 void LocDetails(struct CSC_Board*, int, int*, int*);
 
+/* Work out the pieces which were added and removed by the move that led to
+   the board state (which must be the top of the stack). */
+void FindDirtyPieces(
+    struct CSC_Board*,
+    struct BoardState*,
+    struct CSC_DirtyPieces*);
+
+/* Work out the pawn hash and material key for the pieces on the board. */
+void SetPieceKeys(struct CSC_Board*, struct BoardState*);
+
+/* Check whether the player has a legal en-passent capture onto the square
+   (this decides whether the en-passent file is hashed). */
+bool CanCaptureEnPassent(struct CSC_Board*, int, int);
+
+/* The same check given the pieces and occupancy (e.g. for a CSC_Position). */
+bool PiecesCanCaptureEnPassent(CSC_Bitboard[7][2], CSC_Bitboard, int, int);
+
+/* Get the castling rights after the player moves a piece of the given type
+   from the start to the end location, capturing the given piece (or 0). */
+uint8_t CastlingAfterMove(
+    uint8_t,
+    int,
+    enum CSC_PieceType,
+    int,
+    int,
+    CSC_Piece);
+
+/* Get the pieces belonging to the player which attack the location given the
+   specified occupancy. */
+CSC_Bitboard AttackersOf(struct CSC_Board*, int, CSC_Bitboard, int);
+
+/* Get the pieces (of either colour) which are the only thing blocking a slider
+   from attacking the specified player's king. */
+CSC_Bitboard KingBlockers(struct CSC_Board*, int);
+
+/* Find the checkers and king blockers for the player to move. */
+void UpdateCheckInfo(struct CSC_Board*, struct CheckState*);
+
+/* Get the information for finding moves which give check in the current
+   position (this is worked out the first time it's needed). */
+struct CheckInfo* GetCheckInfo(struct CSC_Board*);
+
 #endif /* __CHESSIC_BOARD_H__ */
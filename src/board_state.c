@@ -10,6 +10,7 @@ struct StateStack* CreateStack()
     struct BoardState* bs;
 
     stack->data = malloc(INITIAL_STACK_SIZE*sizeof(struct BoardState));
+    stack->checks = malloc(INITIAL_STACK_SIZE*sizeof(struct CheckState));
     stack->dataSize = INITIAL_STACK_SIZE;
     stack->head = 0;
 
@@ -17,9 +18,12 @@ struct StateStack* CreateStack()
     bs = &stack->data[0];
     memset(bs, 0, sizeof(struct BoardState));
     bs->enPassentIndex = CSC_BAD_LOC;
-    bs->previousState = NULL;
     bs->hash = 0;
 
+    memset(&stack->checks[0], 0, sizeof(struct CheckState));
+    memset(&stack->derived, 0, sizeof(struct DerivedState));
+    memset(stack->repetitions, 0, sizeof(stack->repetitions));
+
     return stack;
 }
 
@@ -33,6 +37,12 @@ void FreeStack(struct StateStack* stack)
             stack->data = NULL;
         }
 
+        if (stack->checks != NULL)
+        {
+            free(stack->checks);
+            stack->checks = NULL;
+        }
+
         free(stack);
         stack = NULL;
     }
@@ -41,65 +51,80 @@ void FreeStack(struct StateStack* stack)
 struct StateStack* CopyStack(struct StateStack* other)
 {
     struct StateStack* copy = malloc(sizeof(struct StateStack));
-    size_t i;
 
     copy->data = malloc(other->dataSize*sizeof(struct BoardState));
+    copy->checks = malloc(other->dataSize*sizeof(struct CheckState));
     copy->dataSize = other->dataSize;
     copy->head = other->head;
 
-    memcpy(copy->data, other->data, copy->dataSize*sizeof(struct BoardState));
+    memcpy(copy->data, other->data, (copy->head + 1)*sizeof(struct BoardState));
+    memcpy(
+        copy->checks,
+        other->checks,
+        (copy->head + 1)*sizeof(struct CheckState));
+    copy->derived = other->derived;
 
-    /* Sort out pointers: currently they will point to the original's elements. */
-    for (i = 1; i <= copy->head; i++)
-    {
-        copy->data[i].previousState = &copy->data[i-1];
-    }
+    memcpy(copy->repetitions, other->repetitions, sizeof(copy->repetitions));
 
     return copy;
 }
 
+void Reserve(struct StateStack* stack, size_t size)
+{
+    if (size > stack->dataSize)
+    {
+        stack->data = realloc(stack->data, size*sizeof(struct BoardState));
+        stack->checks = realloc(stack->checks, size*sizeof(struct CheckState));
+        stack->dataSize = size;
+    }
+}
+
 /* Push a new board state to the stack and return a pointer to the new element. */
 /* If the current maximum stack size has been reached then the stack gets
-   re-allocated with a larger buffer. When this happens any pointers to the
-   previous elements become invalid - so they should not be accessed after
-   this function is called. */
+   re-allocated with a larger buffer. */
 struct BoardState* Push(struct StateStack* stack)
 {
-    struct BoardState* origData;
-    size_t origSize, i;
-
-    if (stack->head < stack->dataSize - 1)
+    if (stack->head == stack->dataSize - 1)
     {
-        ++stack->head;
-        stack->data[stack->head].previousState = &stack->data[stack->head - 1];
+        Reserve(stack, stack->dataSize << 1);
     }
-    else
-    {
-        origData = stack->data;
-        origSize = stack->dataSize;
-        stack->dataSize <<= 1;
-        stack->data = malloc(stack->dataSize*sizeof(struct BoardState));
-        memcpy(stack->data, origData, origSize*sizeof(struct BoardState));
-        free(origData);
 
-        ++stack->head;
+    ++stack->repetitions[
+        stack->data[stack->head].hash & (REPETITION_TABLE_SIZE - 1)];
 
-        for (i = 1; i <= stack->head; i++)
-        {
-            stack->data[i].previousState = &stack->data[i-1];
-        }
-    }
-
-    return &stack->data[stack->head];
+    return &stack->data[++stack->head];
 }
 
 struct BoardState* Pop(struct StateStack* stack)
 {
+    struct BoardState* popped;
+
     assert(stack->head > 0);
-    return &stack->data[stack->head--];
+
+    popped = &stack->data[stack->head--];
+
+    --stack->repetitions[
+        stack->data[stack->head].hash & (REPETITION_TABLE_SIZE - 1)];
+
+    return popped;
 }
 
 struct BoardState* Top(struct StateStack* stack)
 {
     return &stack->data[stack->head];
 }
+
+struct CheckState* TopChecks(struct StateStack* stack)
+{
+    return &stack->checks[stack->head];
+}
+
+struct DerivedState* TopDerived(struct StateStack* stack)
+{
+    return &stack->derived;
+}
+
+int RepetitionCount(struct StateStack* stack, CSC_Hash hash)
+{
+    return stack->repetitions[hash & (REPETITION_TABLE_SIZE - 1)];
+}
@@ -4,47 +4,132 @@
 #include "chessic.h"
 #include "stdlib.h"
 
+/* The information needed to find the moves which give check. */
+struct CheckInfo
+{
+    /* The location of the enemy king. */
+    int enemyKing;
+
+    /* The squares each piece type would give check from. */
+    CSC_Bitboard squares[7];
+
+    /* The pieces belonging to the player to move which would give a
+       discovered check by moving off the line to the enemy king. */
+    CSC_Bitboard discoverers;
+};
+
+/* The castling rights are stored as a mask with a bit per player and side. */
+#define CASTLE_KINGSIDE(p) (1 << 2*(p))
+#define CASTLE_QUEENSIDE(p) (2 << 2*(p))
+
+/* The state that varies per move and is needed to undo moves or to look back
+   through the history. This is kept to 32 bytes so that walking the history
+   is cache friendly. */
 struct BoardState
 {
+    /* The current board hash. */
+    CSC_Hash hash;
+
+    /* The hash of just the pawns. */
+    CSC_Hash pawnHash;
+
     /* The move that was applied to reach this state. */
     CSC_Move lastMove;
 
+    /* A hash of the number of each type of piece that each player has. */
+    uint32_t materialKey;
+
+    /* The number of plies since the last move that reset the 50 move rule. */
+    uint16_t plies50Move;
+
+    /* The number of plies since the last null move (or the start of the
+       history), which bounds how far back a repetition can be. */
+    uint16_t pliesFromNull;
+
     /* The piece that was captured on the last move. */
-    CSC_Piece lastMoveCapture;
+    uint8_t lastMoveCapture;
 
     /* The type of piece that moved on the last move. */
-    enum CSC_PieceType lastMovePieceType;
+    uint8_t lastMovePieceType;
 
     /* The index of the square where an en-passent capture is possible. */
-    int enPassentIndex;
+    int8_t enPassentIndex;
 
-    /* The number of plies since the last move that reset the 50 move rule. */
-    int plies50Move;
+    /* The castling rights for both players. */
+    uint8_t castling;
+};
 
-    /* The castling rights for each player. */
-    struct CSC_CastlingRights castlingRights[2];
+/* This fails to compile if the state grows beyond 32 bytes. */
+typedef char BoardStateSizeCheck[sizeof(struct BoardState) <= 32 ? 1 : -1];
 
-    /* The current board hash. */
-    CSC_Hash hash;
+/* The checks and pins in the position, which are worked out from the pieces
+   when a move is made. These are kept for each ply (beside the board states)
+   so that undoing a move doesn't need to work them out again. */
+struct CheckState
+{
+    /* The pieces giving check to the player to move. */
+    CSC_Bitboard checkers;
 
-    /* The previous game state. */
-    struct BoardState* previousState;
+    /* The pieces (of either colour) which are the only thing blocking a slider
+       from attacking the king of the player to move. */
+    CSC_Bitboard blockers;
+};
+
+/* This fails to compile if the check state grows beyond 16 bytes. */
+typedef char CheckStateSizeCheck[sizeof(struct CheckState) <= 16 ? 1 : -1];
+
+/* The information about the position which is only worked out when it's
+   needed. Only the top of the stack has this (it's invalidated when a move is
+   undone), so it doesn't add to the size of the history. */
+struct DerivedState
+{
+    /* This is only filled in when it's first needed. */
+    bool checkInfoValid;
+    struct CheckInfo checkInfo;
+
+    /* The pieces added and removed by the move which led to this state. This
+       is recorded when the move is made, but after a move is undone it's only
+       filled in when it's first needed. */
+    bool dirtyValid;
+    struct CSC_DirtyPieces dirty;
 };
 
+/* The number of counters used to find repetitions (must be a power of 2). */
+#define REPETITION_TABLE_SIZE 2048
+
+/* The states are stored by index (the previous state of the element at index
+   i is at index i-1), so growing or copying the stack doesn't need to fix up
+   any pointers. */
 struct StateStack
 {
     struct BoardState* data;
+    struct CheckState* checks;
     size_t dataSize;
     size_t head;
+
+    /* The number of states below the top whose hash maps to each counter. If
+       the counter for the top state's hash is zero then it can't be a
+       repetition. */
+    uint16_t repetitions[REPETITION_TABLE_SIZE];
+
+    /* The derived state for the top element. */
+    struct DerivedState derived;
 };
 
 struct StateStack* CreateStack();
 
 void FreeStack(struct StateStack*);
 
+/* The copy has the same capacity but only the used elements are copied. */
 struct StateStack* CopyStack(struct StateStack*);
 
-/* Increase the size of the stack by 1 and get a pointer to the new element. */
+/* Make sure that the stack has space for at least the specified number of
+   elements. */
+void Reserve(struct StateStack*, size_t);
+
+/* Increase the size of the stack by 1 and get a pointer to the new element.
+   If the stack has to grow then pointers to the existing elements become
+   invalid. The hash of the current top element must be final. */
 struct BoardState* Push(struct StateStack*);
 
 /* Reduce the size of the stack by 1. */
@@ -53,4 +138,13 @@ struct BoardState* Pop(struct StateStack*);
 /* Access the top element of the stack. */
 struct BoardState* Top(struct StateStack*);
 
+/* Access the checks and pins for the top element of the stack. */
+struct CheckState* TopChecks(struct StateStack*);
+
+/* Access the derived state for the top element of the stack. */
+struct DerivedState* TopDerived(struct StateStack*);
+
+/* Get the number of states below the top which might have the same hash. */
+int RepetitionCount(struct StateStack*, CSC_Hash);
+
 #endif /* __CHESSIC_BOARD_STATE_H__ */
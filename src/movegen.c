@@ -1,66 +1,180 @@
 #include "chessic.h"
+#include "board.h"
 #include "board_state.h"
+#include "movegen.h"
+
+/* The information needed to generate only legal moves. This is computed once
+   at the start of move generation. */
+struct LegalityInfo
+{
+    /* The location of the king belonging to the player to move. */
+    int king;
+
+    /* The enemy pieces which are giving check. */
+    CSC_Bitboard checkers;
+
+    /* The pieces belonging to the player to move which are pinned to the
+       king. */
+    CSC_Bitboard pinned;
+
+    /* The number of moves found when counting rather than generating moves
+       (this is the case when the move list is NULL). */
+    int count;
+
+    /* Whether quiet moves are restricted to those which give check, in which
+       case the squares to give check from are needed. */
+    bool quietChecks;
+    struct CheckInfo* check;
+};
 
 void AddMove(
-    struct CSC_Board* b,
     struct CSC_MoveList* l,
+    struct LegalityInfo* info,
     CSC_Move move)
 {
-    /* Check whether the move is legal and add to the list if it is. */
-    if (CSC_IsLegal(b, move))
+    if (l != NULL)
     {
         CSC_AddMove(l, move);
     }
+    else
+    {
+        ++info->count;
+    }
 }
 
-void AddPawnMoves(
+/* Check whether moving a piece from start to end keeps it on its pin ray
+   (this is always true for pieces which are not pinned). */
+bool StaysOnPinRay(struct LegalityInfo* info, int start, int end)
+{
+    return !CSC_Test(info->pinned, start)
+        || CSC_Test(CSC_Line[info->king][start], end);
+}
+
+/* Get the pawn moves by d squares whose start square is pinned. */
+CSC_Bitboard PinnedPawnMoves(
+    CSC_Bitboard ends,
+    struct LegalityInfo* info,
+    int d)
+{
+    return ends & (d > 0 ? info->pinned << d : info->pinned >> -d);
+}
+
+/* When only quiet checks are wanted, remove the quiet moves which don't give
+   check from the piece's moves. */
+CSC_Bitboard RestrictToChecks(
+    struct CSC_Board* b,
+    struct LegalityInfo* info,
+    int loc,
+    CSC_Bitboard ends)
+{
+    CSC_Bitboard checks;
+
+    if (!info->quietChecks) return ends;
+
+    checks = info->check->squares[CSC_GetPieceType(b->squares[loc])];
+    if (CSC_Test(info->check->discoverers, loc))
+    {
+        checks |= ~CSC_Line[info->check->enemyKing][loc];
+    }
+
+    return ends & (b->all[1-b->player] | checks);
+}
+
+/* Add the promotions by pushing a pawn which give check. */
+void AddCheckingPromoMoves(
     struct CSC_Board* b,
     CSC_Bitboard ends,
     struct CSC_MoveList* l,
+    struct LegalityInfo* info,
+    int d)
+{
+    CSC_Move move;
+    int loc, pt;
+    while (ends)
+    {
+        loc = CSC_PopLSB(&ends);
+        if (StaysOnPinRay(info, loc-d, loc))
+        {
+            for (pt = CSC_KNIGHT; pt <= CSC_QUEEN; pt++)
+            {
+                move = CSC_CreateMove(loc-d, loc, pt, CSC_PROMOTION);
+                if (CSC_GivesCheck(b, move)) AddMove(l, info, move);
+            }
+        }
+    }
+}
+
+void AddPawnMoves(
+    CSC_Bitboard ends,
+    struct CSC_MoveList* l,
+    struct LegalityInfo* info,
     int d,
     enum CSC_MoveType type)
 {
     int loc;
+
+    /* When counting, only the moves of pinned pawns need to be examined. */
+    if (l == NULL)
+    {
+        info->count += CSC_PopCount(ends & ~PinnedPawnMoves(ends, info, d));
+        ends = PinnedPawnMoves(ends, info, d);
+    }
+
     while (ends)
     {
         loc = CSC_PopLSB(&ends);
-        AddMove(b, l, CSC_CreateMove(loc-d, loc, CSC_NONE, type));
+        if (StaysOnPinRay(info, loc-d, loc))
+        {
+            AddMove(l, info, CSC_CreateMove(loc-d, loc, CSC_NONE, type));
+        }
     }
 }
 
 void AddPromoMoves(
-    struct CSC_Board* b,
     CSC_Bitboard ends,
     struct CSC_MoveList* l,
+    struct LegalityInfo* info,
     int d)
 {
     int loc;
+
+    if (l == NULL)
+    {
+        info->count += 4*CSC_PopCount(ends & ~PinnedPawnMoves(ends, info, d));
+        ends = PinnedPawnMoves(ends, info, d);
+    }
+
     while (ends)
     {
         loc = CSC_PopLSB(&ends);
-        AddMove(b, l, CSC_CreateMove(loc-d, loc, CSC_KNIGHT, CSC_PROMOTION));
-        AddMove(b, l, CSC_CreateMove(loc-d, loc, CSC_BISHOP, CSC_PROMOTION));
-        AddMove(b, l, CSC_CreateMove(loc-d, loc, CSC_ROOK, CSC_PROMOTION));
-        AddMove(b, l, CSC_CreateMove(loc-d, loc, CSC_QUEEN, CSC_PROMOTION));
+        if (StaysOnPinRay(info, loc-d, loc))
+        {
+            AddMove(l, info, CSC_CreateMove(loc-d, loc, CSC_KNIGHT, CSC_PROMOTION));
+            AddMove(l, info, CSC_CreateMove(loc-d, loc, CSC_BISHOP, CSC_PROMOTION));
+            AddMove(l, info, CSC_CreateMove(loc-d, loc, CSC_ROOK, CSC_PROMOTION));
+            AddMove(l, info, CSC_CreateMove(loc-d, loc, CSC_QUEEN, CSC_PROMOTION));
+        }
     }
 }
 
 /* When generating pawn moves we need to deal en passent moves, which don't
    follow the pattern of capturing the target square.
-   To deal with this we need the "QUIETS" move type to be passed in if  the
-   user wants to exclude them. */
+   To deal with this the caller decides whether the en-passent square is
+   included in the targets. */
 void FindPawnMoves(
     struct CSC_Board* b,
     struct CSC_MoveList* l,
+    struct LegalityInfo* info,
     CSC_Bitboard targets)
 {
     int p = b->player;
     CSC_Bitboard enemies = b->all[1-p];
     CSC_Bitboard all = b->all[CSC_WHITE] | b->all[CSC_BLACK];
     CSC_Bitboard promo = p == CSC_WHITE ? CSC_Ranks[6] : CSC_Ranks[1];
-    CSC_Bitboard pawns, f1, f2;
+    CSC_Bitboard pawns, f1, f2, disc;
     CSC_Bitboard leftCapPawns, rightCapPawns, leftCaps, rightCaps;
     CSC_Bitboard ep, caps;
+    CSC_Move move;
     int forward = p == CSC_WHITE ? CSC_FILE_NB : -CSC_FILE_NB;
     int capLeft = CSC_FILE_NB-1;
     int capRight = CSC_FILE_NB+1;
@@ -80,8 +194,23 @@ void FindPawnMoves(
 
     f2 &= ~all;
 
-    AddPawnMoves(b, f1 & targets, l, forward, CSC_NORMAL);
-    AddPawnMoves(b, f2 & targets, l, 2*forward, CSC_TWOSPACE);
+    /* Pushes give check if they land on a square attacking the enemy king or
+       if they move a pawn off a line to it (which can't be its file). */
+    if (info->quietChecks)
+    {
+        disc = pawns
+            & info->check->discoverers
+            & ~CSC_Files[info->check->enemyKing % CSC_FILE_NB];
+
+        f1 &= info->check->squares[CSC_PAWN]
+            | (p == CSC_WHITE ? disc << CSC_FILE_NB : disc >> CSC_FILE_NB);
+
+        f2 &= info->check->squares[CSC_PAWN]
+            | (p == CSC_WHITE ? disc << 2*CSC_FILE_NB : disc >> 2*CSC_FILE_NB);
+    }
+
+    AddPawnMoves(f1 & targets, l, info, forward, CSC_NORMAL);
+    AddPawnMoves(f2 & targets, l, info, 2*forward, CSC_TWOSPACE);
 
     /* Normal and en-passent captures (without promotions). */
     pawns = b->pieces[CSC_PAWN][p] & ~promo;
@@ -100,15 +229,15 @@ void FindPawnMoves(
         : rightCapPawns >> capLeft;
 
     AddPawnMoves(
-        b,
         leftCaps & enemies & targets,
         l,
+        info,
         p == CSC_WHITE ? capLeft : -capRight, CSC_NORMAL);
 
     AddPawnMoves(
-        b,
         rightCaps & enemies & targets,
         l,
+        info,
         p == CSC_WHITE ? capRight : -capLeft, CSC_NORMAL);
 
     epLoc = CSC_GetEnPassentIndex(b);
@@ -130,9 +259,12 @@ void FindPawnMoves(
 
         caps &= pawns;
 
+        /* En-passent captures remove two pieces from the same rank, which can
+           expose the king, so they always need the full legality check. */
         while (caps)
         {
-            AddMove(b, l, CSC_CreateMove(CSC_PopLSB(&caps), epLoc, CSC_NONE, CSC_ENPASSENT));
+            move = CSC_CreateMove(CSC_PopLSB(&caps), epLoc, CSC_NONE, CSC_ENPASSENT);
+            if (CSC_IsLegal(b, move)) AddMove(l, info, move);
         }
     }
 
@@ -143,7 +275,14 @@ void FindPawnMoves(
         f1 = p == CSC_WHITE ? pawns << CSC_FILE_NB : pawns >> CSC_FILE_NB;
         f1 &= ~all;
 
-        AddPromoMoves(b, f1 & targets, l, forward);
+        if (info->quietChecks)
+        {
+            AddCheckingPromoMoves(b, f1 & targets, l, info, forward);
+        }
+        else
+        {
+            AddPromoMoves(f1 & targets, l, info, forward);
+        }
 
         /* Ensure that no captures wrap around the struct CSC_Board. */
         leftCapPawns = pawns & ~CSC_Files[0];
@@ -159,88 +298,93 @@ void FindPawnMoves(
             : rightCapPawns >> capLeft;
 
         AddPromoMoves(
-            b,
             leftCaps & enemies & targets,
             l,
+            info,
             p == CSC_WHITE ? capLeft : -capRight);
 
         AddPromoMoves(
-            b,
             rightCaps & enemies & targets,
             l,
+            info,
             p == CSC_WHITE ? capRight : -capLeft);
     }
 }
 
 void AddMoves(
-    struct CSC_Board* b,
     int loc,
     struct CSC_MoveList* l,
+    struct LegalityInfo* info,
     CSC_Bitboard ends)
 {
-    while (ends)
+    /* A pinned piece can only move along the line through it and the king. */
+    if (CSC_Test(info->pinned, loc)) ends &= CSC_Line[info->king][loc];
+
+    if (l == NULL)
     {
-        AddMove(b, l, CSC_CreateMove(loc, CSC_PopLSB(&ends), CSC_NONE, CSC_NORMAL));
+        info->count += CSC_PopCount(ends);
+        return;
     }
-}
 
-void FindStepperMoves(
-    struct CSC_Board* b,
-    struct CSC_MoveList* l,
-    CSC_Bitboard steppers,
-    CSC_Bitboard targets,
-    CSC_Bitboard* attacks)
-{
-    int loc;
-    while (steppers)
+    while (ends)
     {
-        loc = CSC_PopLSB(&steppers);
-        AddMoves(b, loc, l, attacks[loc] & targets);
+        CSC_AddMove(l, CSC_CreateMove(loc, CSC_PopLSB(&ends), CSC_NONE, CSC_NORMAL));
     }
 }
 
 void FindKnightMoves(
     struct CSC_Board* b,
     struct CSC_MoveList* l,
+    struct LegalityInfo* info,
     CSC_Bitboard targets)
 {
-    FindStepperMoves(
-        b,
-        l,
-        b->pieces[CSC_KNIGHT][b->player],
-        targets,
-        CSC_KnightAttacks);
+    /* Pinned knights can never move. */
+    CSC_Bitboard knights = b->pieces[CSC_KNIGHT][b->player] & ~info->pinned;
+
+    int loc;
+    while (knights)
+    {
+        loc = CSC_PopLSB(&knights);
+        AddMoves(loc, l, info, RestrictToChecks(b, info, loc, CSC_KnightAttacks[loc] & targets));
+    }
 }
 
+/* This is only called when the player to move is not in check, so the king's
+   starting square is known not to be attacked. */
 void FindCastlingMoves(
     struct CSC_Board* b,
     struct CSC_MoveList* l,
+    struct LegalityInfo* info,
     CSC_Bitboard targets)
 {
     int p = b->player;
     CSC_Bitboard all = b->all[CSC_WHITE] | b->all[CSC_BLACK];
     int startLoc = p == CSC_WHITE ? 4 : 60;
     struct BoardState* state = Top((struct StateStack*)b->states);
-    if (state->castlingRights[p].kingSide && CSC_Test(targets, startLoc+2))
+    if ((state->castling & CASTLE_KINGSIDE(p)) && CSC_Test(targets, startLoc+2))
     {
         if (!CSC_Test(all, startLoc+1)
          && !CSC_Test(all, startLoc+2)
-         && !CSC_IsAttacked(b, startLoc)
-         && !CSC_IsAttacked(b, startLoc+1))
+         && !CSC_IsAttacked(b, startLoc+1)
+         && !CSC_IsAttacked(b, startLoc+2)
+         && (!info->quietChecks
+          || CSC_GivesCheck(b, CSC_CreateMove(startLoc, startLoc+2, CSC_NONE, CSC_KINGCASTLE))))
         {
-            AddMove(b, l, CSC_CreateMove(startLoc, startLoc+2, CSC_NONE, CSC_KINGCASTLE));
+            AddMove(l, info, CSC_CreateMove(startLoc, startLoc+2, CSC_NONE, CSC_KINGCASTLE));
         }
     }
 
-    if (state->castlingRights[p].queenSide && CSC_Test(targets, startLoc-3))
+    if ((state->castling & CASTLE_QUEENSIDE(p)) && CSC_Test(targets, startLoc-3))
     {
         if (!CSC_Test(all, startLoc-1)
          && !CSC_Test(all, startLoc-2)
          && !CSC_Test(all, startLoc-3)
-         && !CSC_IsAttacked(b, startLoc)
-         && !CSC_IsAttacked(b, startLoc-1))
+         && !CSC_IsAttacked(b, startLoc-1)
+         && !CSC_IsAttacked(b, startLoc-2)
+         && (!info->quietChecks
+          || CSC_GivesCheck(b, CSC_CreateMove(startLoc, startLoc-2, CSC_NONE, CSC_QUEENCASTLE))))
         {
-            AddMove(b, l, CSC_CreateMove(startLoc, startLoc-2, CSC_NONE, CSC_QUEENCASTLE));
+            AddMove(l, info, CSC_CreateMove(startLoc, startLoc-2, CSC_NONE, CSC_QUEENCASTLE));
         }
     }
 }
@@ -248,108 +392,162 @@ void FindCastlingMoves(
 void FindKingMoves(
     struct CSC_Board* b,
     struct CSC_MoveList* l,
+    struct LegalityInfo* info,
     CSC_Bitboard targets)
 {
-    FindStepperMoves(b, l, b->pieces[CSC_KING][b->player], targets, CSC_KingAttacks);
-    FindCastlingMoves(b, l, targets);
+    CSC_Bitboard ends = RestrictToChecks(
+        b,
+        info,
+        info->king,
+        CSC_KingAttacks[info->king] & targets);
+    int loc;
+
+    /* The king must not move onto an attacked square. */
+    while (ends)
+    {
+        loc = CSC_PopLSB(&ends);
+        if (!CSC_IsAttacked(b, loc))
+        {
+            AddMove(l, info, CSC_CreateMove(info->king, loc, CSC_NONE, CSC_NORMAL));
+        }
+    }
+
+    FindCastlingMoves(b, l, info, targets);
 }
 
-void FindOrthMoves(
+/* Find the king moves which step out of check. The king is removed from the
+   occupancy first so that it can't step backwards along the checking ray. */
+void FindKingEvasions(
     struct CSC_Board* b,
     struct CSC_MoveList* l,
-    CSC_Bitboard pieces,
-    CSC_Bitboard targets,
-    CSC_Bitboard (*rays)[8])
+    struct LegalityInfo* info,
+    CSC_Bitboard targets)
 {
-    CSC_Bitboard all = b->all[CSC_WHITE] | b->all[CSC_BLACK];
+    CSC_Bitboard ends = RestrictToChecks(
+        b,
+        info,
+        info->king,
+        CSC_KingAttacks[info->king] & targets);
+    CSC_Bitboard occ = (b->all[CSC_WHITE] | b->all[CSC_BLACK])
+        ^ ((CSC_Bitboard)1 << info->king);
+    int loc;
 
-    int p;
-    CSC_Bitboard blockers, ray;
-    while (pieces)
+    while (ends)
     {
-        p = CSC_PopLSB(&pieces);
-
-        ray = rays[p][CSC_NORTH];
-        blockers = ray & all;
-        if (blockers) ray ^= rays[CSC_LSB(blockers)][CSC_NORTH];
-        AddMoves(b, p, l, ray & targets);
-
-        ray = rays[p][CSC_EAST];
-        blockers = ray & all;
-        if (blockers) ray ^= rays[CSC_LSB(blockers)][CSC_EAST];
-        AddMoves(b, p, l, ray & targets);
-
-        ray = rays[p][CSC_SOUTH];
-        blockers = ray & all;
-        if (blockers) ray ^= rays[CSC_MSB(blockers)][CSC_SOUTH];
-        AddMoves(b, p, l, ray & targets);
-
-        ray = rays[p][CSC_WEST];
-        blockers = ray & all;
-        if (blockers) ray ^= rays[CSC_MSB(blockers)][CSC_WEST];
-        AddMoves(b, p, l, ray & targets);
+        loc = CSC_PopLSB(&ends);
+        if (!AttackersOf(b, loc, occ, 1-b->player))
+        {
+            AddMove(l, info, CSC_CreateMove(info->king, loc, CSC_NONE, CSC_NORMAL));
+        }
     }
 }
 
-void FindDiagMoves(
+void FindSliderMoves(
     struct CSC_Board* b,
     struct CSC_MoveList* l,
+    struct LegalityInfo* info,
     CSC_Bitboard pieces,
     CSC_Bitboard targets,
-    CSC_Bitboard (*rays)[8])
+    CSC_Bitboard (*attacks)(int, CSC_Bitboard))
 {
     CSC_Bitboard all = b->all[CSC_WHITE] | b->all[CSC_BLACK];
 
     int p;
-    CSC_Bitboard blockers, ray;
     while (pieces)
     {
         p = CSC_PopLSB(&pieces);
+        AddMoves(p, l, info, RestrictToChecks(b, info, p, attacks(p, all) & targets));
+    }
+}
+
+/* Find the moves for all pieces other than the king. */
+void FindPieceMoves(
+    struct CSC_Board* b,
+    struct CSC_MoveList* l,
+    struct LegalityInfo* info,
+    CSC_Bitboard targets,
+    CSC_Bitboard pawnTargets)
+{
+    CSC_Bitboard orth, diag;
+
+    FindKnightMoves(b, l, info, targets);
+
+    orth = b->pieces[CSC_ROOK][b->player] | b->pieces[CSC_QUEEN][b->player];
+    FindSliderMoves(b, l, info, orth, targets, CSC_RookAttacks);
+
+    diag = b->pieces[CSC_BISHOP][b->player] | b->pieces[CSC_QUEEN][b->player];
+    FindSliderMoves(b, l, info, diag, targets, CSC_BishopAttacks);
+
+    FindPawnMoves(b, l, info, pawnTargets);
+}
+
+/* Generate the moves which get out of check. Either the king moves, or (if
+   there is only a single checker) the checker is captured or blocked. */
+void FindEvasions(
+    struct CSC_Board* b,
+    struct CSC_MoveList* l,
+    struct LegalityInfo* info,
+    CSC_Bitboard targets,
+    CSC_Bitboard pawnTargets)
+{
+    CSC_Bitboard blocks;
+    int checker, epLoc;
 
-        ray = rays[p][CSC_NORTHWEST];
-        blockers = ray & all;
-        if (blockers) ray ^= rays[CSC_LSB(blockers)][CSC_NORTHWEST];
-        AddMoves(b, p, l, ray & targets);
-
-        ray = rays[p][CSC_NORTHEAST];
-        blockers = ray & all;
-        if (blockers) ray ^= rays[CSC_LSB(blockers)][CSC_NORTHEAST];
-        AddMoves(b, p, l, ray & targets);
-
-        ray = rays[p][CSC_SOUTHWEST];
-        blockers = ray & all;
-        if (blockers) ray ^= rays[CSC_MSB(blockers)][CSC_SOUTHWEST];
-        AddMoves(b, p, l, ray & targets);
-
-        ray = rays[p][CSC_SOUTHEAST];
-        blockers = ray & all;
-        if (blockers) ray ^= rays[CSC_MSB(blockers)][CSC_SOUTHEAST];
-        AddMoves(b, p, l, ray & targets);
+    FindKingEvasions(b, l, info, targets);
+
+    /* In double check only the king can move. */
+    if (info->checkers & (info->checkers - 1)) return;
+
+    checker = CSC_LSB(info->checkers);
+    blocks = CSC_Between[info->king][checker] | info->checkers;
+
+    /* The checker could be a pawn which can be captured en-passent (this is
+       the only capture which doesn't land on the checker's square). */
+    epLoc = CSC_GetEnPassentIndex(b);
+    if (epLoc != CSC_BAD_LOC
+     && CSC_Test(pawnTargets, epLoc)
+     && epLoc + (b->player == CSC_WHITE ? -CSC_FILE_NB : CSC_FILE_NB) == checker)
+    {
+        pawnTargets &= blocks | ((CSC_Bitboard)1 << epLoc);
+    }
+    else
+    {
+        pawnTargets &= blocks;
     }
+
+    FindPieceMoves(b, l, info, targets & blocks, pawnTargets);
 }
 
-void CSC_GetMoves(
+int GenerateMoves(
     struct CSC_Board* b,
     struct CSC_MoveList* l,
     enum CSC_MoveGenType type)
 {
-    CSC_Bitboard targets, orth, diag, ep;
+    struct CheckState* cs = TopChecks((struct StateStack*)b->states);
+    CSC_Bitboard targets, pawnTargets, ep;
+    struct LegalityInfo info;
     int epLoc;
+    int start = l != NULL ? l->n : 0;
 
-    if (CSC_IsDrawn(b)) return;
+    info.king = CSC_LSB(b->pieces[CSC_KING][b->player]);
+    info.checkers = cs->checkers;
+    info.pinned = cs->blockers & b->all[b->player];
+    info.count = 0;
+    info.quietChecks = (type & CSC_QUIET_CHECKS) && !(type & CSC_QUIETS);
 
     targets = 0;
     if (type & CSC_QUIETS) targets |= ~(b->all[CSC_WHITE] | b->all[CSC_BLACK]);
     if (type & CSC_CAPTURES) targets |= b->all[1-b->player];
 
-    FindKnightMoves(b, l, targets);
-    FindKingMoves(b, l, targets);
-
-    orth = b->pieces[CSC_ROOK][b->player] | b->pieces[CSC_QUEEN][b->player];
-    FindOrthMoves(b, l, orth, targets, CSC_RayAttacks);
+    /* The quiet moves are generated as normal, but each piece type is then
+       restricted to the squares which give check. */
+    if (info.quietChecks)
+    {
+        info.check = GetCheckInfo(b);
+        targets |= ~(b->all[CSC_WHITE] | b->all[CSC_BLACK]);
+    }
 
-    diag = b->pieces[CSC_BISHOP][b->player] | b->pieces[CSC_QUEEN][b->player];
-    FindDiagMoves(b, l, diag, targets, CSC_RayAttacks);
+    pawnTargets = targets;
 
     epLoc = CSC_GetEnPassentIndex(b);
     if (epLoc != CSC_BAD_LOC)
@@ -357,13 +555,157 @@ void CSC_GetMoves(
       ep = (CSC_Bitboard)1 << epLoc;
       if (type & CSC_CAPTURES)
       {
-        targets |= ep;
+        pawnTargets |= ep;
       }
       else
       {
-        targets &= ~ep;
+        pawnTargets &= ~ep;
       }
     }
 
-    FindPawnMoves(b, l, targets);
+    if (info.checkers)
+    {
+        FindEvasions(b, l, &info, targets, pawnTargets);
+    }
+    else
+    {
+        FindKingMoves(b, l, &info, targets);
+        FindPieceMoves(b, l, &info, targets, pawnTargets);
+    }
+
+    return l != NULL ? l->n - start : info.count;
+}
+
+bool CSC_IsPseudoLegal(struct CSC_Board* b, CSC_Move m)
+{
+    struct BoardState* bs = Top((struct StateStack*)b->states);
+    int p = b->player;
+    int s = CSC_GetMoveStart(m);
+    int e = CSC_GetMoveEnd(m);
+    int promo = CSC_GetMovePromotion(m);
+    int forward = p == CSC_WHITE ? CSC_FILE_NB : -CSC_FILE_NB;
+    int startLoc = p == CSC_WHITE ? 4 : 60;
+    enum CSC_MoveType mt = CSC_GetMoveType(m);
+    enum CSC_PieceType pt = CSC_GetPieceType(b->squares[s]);
+    CSC_Bitboard all = b->all[CSC_WHITE] | b->all[CSC_BLACK];
+    CSC_Bitboard lastRank = p == CSC_WHITE ? CSC_Ranks[7] : CSC_Ranks[0];
+    CSC_Piece rook = CSC_CreatePiece(p, CSC_ROOK);
+
+    /* Reject values with bits set outside of the move fields, since these
+       wouldn't compare equal to the generated moves. */
+    if (m >> 21) return false;
+
+    if (pt == CSC_NONE || CSC_GetPieceColour(b->squares[s]) != p) return false;
+    if (CSC_Test(b->all[p], e)) return false;
+    if (mt != CSC_PROMOTION && promo != CSC_NONE) return false;
+
+    if (pt == CSC_PAWN)
+    {
+        /* Moves to the last rank must be promotions. */
+        if ((mt == CSC_PROMOTION) != CSC_Test(lastRank, e)) return false;
+
+        switch (mt)
+        {
+            case CSC_NORMAL:
+            case CSC_PROMOTION:
+                if (mt == CSC_PROMOTION && (promo < CSC_KNIGHT || promo > CSC_QUEEN))
+                {
+                    return false;
+                }
+
+                return (e == s + forward && !CSC_Test(all, e))
+                    || (CSC_Test(CSC_PawnAttacks[p][s], e)
+                     && CSC_Test(b->all[1-p], e));
+
+            case CSC_TWOSPACE:
+                return CSC_Test(p == CSC_WHITE ? CSC_Ranks[1] : CSC_Ranks[6], s)
+                    && e == s + 2*forward
+                    && !CSC_Test(all, s + forward)
+                    && !CSC_Test(all, e);
+
+            case CSC_ENPASSENT:
+                return e == bs->enPassentIndex
+                    && CSC_Test(CSC_PawnAttacks[p][s], e);
+
+            default:
+                return false;
+        }
+    }
+
+    switch (mt)
+    {
+        case CSC_NORMAL:
+            break;
+
+        /* Castling can't be out of check or through an attacked square. The
+           king's end square is checked by CSC_IsLegal as for other king
+           moves. */
+        case CSC_KINGCASTLE:
+            return pt == CSC_KING
+                && (bs->castling & CASTLE_KINGSIDE(p))
+                && s == startLoc
+                && e == s+2
+                && b->squares[s+3] == rook
+                && !CSC_Test(all, s+1)
+                && !CSC_Test(all, s+2)
+                && !CSC_InCheck(b)
+                && !CSC_IsAttacked(b, s+1);
+
+        case CSC_QUEENCASTLE:
+            return pt == CSC_KING
+                && (bs->castling & CASTLE_QUEENSIDE(p))
+                && s == startLoc
+                && e == s-2
+                && b->squares[s-4] == rook
+                && !CSC_Test(all, s-1)
+                && !CSC_Test(all, s-2)
+                && !CSC_Test(all, s-3)
+                && !CSC_InCheck(b)
+                && !CSC_IsAttacked(b, s-1);
+
+        default:
+            return false;
+    }
+
+    switch (pt)
+    {
+        case CSC_KNIGHT: return CSC_Test(CSC_KnightAttacks[s], e);
+        case CSC_BISHOP: return CSC_Test(CSC_BishopAttacks(s, all), e);
+        case CSC_ROOK: return CSC_Test(CSC_RookAttacks(s, all), e);
+        case CSC_QUEEN:
+            return CSC_Test(CSC_BishopAttacks(s, all) | CSC_RookAttacks(s, all), e);
+        default: return CSC_Test(CSC_KingAttacks[s], e);
+    }
+}
+
+void CSC_GetMoves(
+    struct CSC_Board* b,
+    struct CSC_MoveList* l,
+    enum CSC_MoveGenType type)
+{
+    if (CSC_IsDrawn(b)) return;
+    GenerateMoves(b, l, type);
+}
+
+int CSC_CountMoves(
+    struct CSC_Board* b,
+    enum CSC_MoveGenType type)
+{
+    if (CSC_IsDrawn(b)) return 0;
+    return GenerateMoves(b, NULL, type);
+}
+
+void CSC_GetMovesNoDrawCheck(
+    struct CSC_Board* b,
+    struct CSC_MoveList* l,
+    enum CSC_MoveGenType type)
+{
+    GenerateMoves(b, l, type);
+}
+
+int CSC_CountMovesNoDrawCheck(
+    struct CSC_Board* b,
+    enum CSC_MoveGenType type)
+{
+    return GenerateMoves(b, NULL, type);
 }
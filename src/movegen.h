@@ -0,0 +1,15 @@
+#ifndef __CHESSIC_MOVEGEN_H__
+#define __CHESSIC_MOVEGEN_H__
+
+#include "chessic.h"
+
+/* Generate the legal moves of the specified type. Unlike CSC_GetMoves this
+   does not check whether the game is drawn. If the move list is NULL the
+   moves are only counted. The moves are appended to the list, and the number
+   of moves added (or counted) is returned. */
+int GenerateMoves(
+    struct CSC_Board*,
+    struct CSC_MoveList*,
+    enum CSC_MoveGenType);
+
+#endif /* __CHESSIC_MOVEGEN_H__ */
@@ -0,0 +1,224 @@
+#include "chessic.h"
+#include "movegen.h"
+
+enum PickerStage
+{
+    HASH_MOVE,
+    GENERATE_CAPTURES,
+    GOOD_CAPTURES,
+    KILLERS,
+    GENERATE_QUIETS,
+    QUIETS,
+    BAD_CAPTURES,
+    DONE
+};
+
+bool IsCapture(struct CSC_Board* b, CSC_Move m)
+{
+    return b->squares[CSC_GetMoveEnd(m)] != 0
+        || CSC_GetMoveType(m) == CSC_ENPASSENT;
+}
+
+/* Check whether the move has already been returned by an earlier stage. */
+bool AlreadyPicked(struct CSC_MovePicker* mp, CSC_Move m)
+{
+    int i;
+
+    if (m == mp->hashMove) return true;
+
+    /* Killers which weren't returned have been cleared by this point. */
+    if (mp->stage > KILLERS)
+    {
+        for (i = 0; i < CSC_NUM_KILLERS; i++)
+        {
+            if (m == mp->killers[i]) return true;
+        }
+    }
+
+    return false;
+}
+
+/* Score captures by the most valuable victim and then by the least valuable
+   attacker (the piece types are in order of value). This decides the order in
+   which the captures are tried, and the static exchange evaluation decides
+   whether they're tried before or after the quiet moves. */
+void ScoreCaptures(struct CSC_MovePicker* mp)
+{
+    struct CSC_Board* b = mp->board;
+    enum CSC_PieceType victim, attacker;
+    CSC_Move m;
+    int i;
+
+    for (i = 0; i < mp->numMoves; i++)
+    {
+        m = mp->moves[i];
+        victim = CSC_GetMoveType(m) == CSC_ENPASSENT
+            ? CSC_PAWN
+            : CSC_GetPieceType(b->squares[CSC_GetMoveEnd(m)]);
+
+        attacker = CSC_GetPieceType(b->squares[CSC_GetMoveStart(m)]);
+
+        mp->scores[i] = 8*victim - attacker;
+        if (CSC_GetMoveType(m) == CSC_PROMOTION)
+        {
+            mp->scores[i] += 8*CSC_GetMovePromotion(m);
+        }
+    }
+}
+
+/* Generate the moves for the next stage into the picker, after the moves
+   which are being kept for a later stage. */
+void GenerateStage(
+    struct CSC_MovePicker* mp,
+    enum CSC_MoveGenType type,
+    int start)
+{
+    struct CSC_MoveList l;
+
+    l.moves = mp->moves + start;
+    l.n = 0;
+
+    GenerateMoves(mp->board, &l, type);
+
+    mp->numMoves = start + l.n;
+    mp->current = start;
+}
+
+/* Find the next move in the current stage. If the moves are scored this does
+   a partial selection sort, since we'll often only need the first few. */
+CSC_Move PickNext(struct CSC_MovePicker* mp, bool scored)
+{
+    CSC_Move m;
+    int best, i, score;
+
+    while (mp->current < mp->numMoves)
+    {
+        best = mp->current;
+        for (i = mp->current + 1; scored && i < mp->numMoves; i++)
+        {
+            if (mp->scores[i] > mp->scores[best]) best = i;
+        }
+
+        m = mp->moves[best];
+        score = mp->scores[best];
+        mp->moves[best] = mp->moves[mp->current];
+        mp->scores[best] = mp->scores[mp->current];
+        mp->moves[mp->current] = m;
+        mp->scores[mp->current] = score;
+        ++mp->current;
+
+        if (!AlreadyPicked(mp, m)) return m;
+    }
+
+    return CSC_NO_MOVE;
+}
+
+void CSC_InitMovePicker(
+    struct CSC_MovePicker* mp,
+    struct CSC_Board* b,
+    CSC_Move hashMove,
+    CSC_Move* killers)
+{
+    int i;
+
+    mp->board = b;
+    mp->stage = HASH_MOVE;
+    mp->hashMove = hashMove;
+    mp->numMoves = 0;
+    mp->current = 0;
+    mp->numBadCaptures = 0;
+
+    for (i = 0; i < CSC_NUM_KILLERS; i++)
+    {
+        mp->killers[i] = killers != NULL ? killers[i] : CSC_NO_MOVE;
+    }
+}
+
+CSC_Move CSC_NextMove(struct CSC_MovePicker* mp)
+{
+    struct CSC_Board* b = mp->board;
+    CSC_Move m;
+
+    switch (mp->stage)
+    {
+        case HASH_MOVE:
+            ++mp->stage;
+
+            /* Moves from the hash table can be garbage (e.g. after a hash
+               collision) so they must be checked. If it isn't valid it can't
+               match any of the generated moves, so it's cleared. */
+            if (CSC_IsPseudoLegal(b, mp->hashMove) && CSC_IsLegal(b, mp->hashMove))
+            {
+                return mp->hashMove;
+            }
+
+            mp->hashMove = CSC_NO_MOVE;
+
+            /* Fallthrough. */
+        case GENERATE_CAPTURES:
+            GenerateStage(mp, CSC_CAPTURES, 0);
+            ScoreCaptures(mp);
+            ++mp->stage;
+
+            /* Fallthrough. */
+        case GOOD_CAPTURES:
+            /* Captures which lose material are moved to the start of the list
+               (over moves which have already been picked) to be tried after
+               the quiet moves. */
+            while ((m = PickNext(mp, true)) != CSC_NO_MOVE)
+            {
+                if (CSC_SEEGreaterOrEqual(b, m, 0)) return m;
+                mp->moves[mp->numBadCaptures++] = m;
+            }
+
+            ++mp->stage;
+            mp->current = 0;
+
+            /* Fallthrough. */
+        case KILLERS:
+            /* Killers are quiet moves from sibling nodes so they may not be
+               valid here. Captures will already have been tried. Any killers
+               which aren't returned are cleared so that they aren't skipped
+               in the quiet stage. */
+            while (mp->current < CSC_NUM_KILLERS)
+            {
+                m = mp->killers[mp->current];
+                if (m != mp->hashMove
+                 && (mp->current == 0 || m != mp->killers[0])
+                 && CSC_IsPseudoLegal(b, m)
+                 && !IsCapture(b, m)
+                 && CSC_IsLegal(b, m))
+                {
+                    ++mp->current;
+                    return m;
+                }
+
+                mp->killers[mp->current++] = CSC_NO_MOVE;
+            }
+
+            ++mp->stage;
+
+            /* Fallthrough. */
+        case GENERATE_QUIETS:
+            GenerateStage(mp, CSC_QUIETS, mp->numBadCaptures);
+            ++mp->stage;
+
+            /* Fallthrough. */
+        case QUIETS:
+            m = PickNext(mp, false);
+            if (m != CSC_NO_MOVE) return m;
+            ++mp->stage;
+            mp->current = 0;
+            mp->numMoves = mp->numBadCaptures;
+
+            /* Fallthrough. */
+        case BAD_CAPTURES:
+            m = PickNext(mp, false);
+            if (m != CSC_NO_MOVE) return m;
+            ++mp->stage;
+
+            /* Fallthrough. */
+        default:
+            return CSC_NO_MOVE;
+    }
+}
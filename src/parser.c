@@ -128,22 +128,22 @@ struct CSC_Board* CSC_BoardFromFEN(const char* fen)
         c = token[i];
         if (c == 'K')
         {
-            bs->castlingRights[CSC_WHITE].kingSide = true;
+            bs->castling |= CASTLE_KINGSIDE(CSC_WHITE);
             bs->hash ^= keys.castling[CSC_WHITE][0];
         }
         else if (c == 'Q')
         {
-            bs->castlingRights[CSC_WHITE].queenSide = true;
+            bs->castling |= CASTLE_QUEENSIDE(CSC_WHITE);
             bs->hash ^= keys.castling[CSC_WHITE][1];
         }
         else if (c == 'k')
         {
-            bs->castlingRights[CSC_BLACK].kingSide = true;
+            bs->castling |= CASTLE_KINGSIDE(CSC_BLACK);
             bs->hash ^= keys.castling[CSC_BLACK][0];
         }
         else if (c == 'q')
         {
-            bs->castlingRights[CSC_BLACK].queenSide = true;
+            bs->castling |= CASTLE_QUEENSIDE(CSC_BLACK);
             bs->hash ^= keys.castling[CSC_BLACK][1];
         }
     }
@@ -153,7 +153,8 @@ struct CSC_Board* CSC_BoardFromFEN(const char* fen)
     if (token[0] != '-')
     {
         bs->enPassentIndex = LocFromFEN(token);
-        bs->hash ^= keys.enpassentFile[bs->enPassentIndex % CSC_FILE_NB];
+        if (CanCaptureEnPassent(b, bs->enPassentIndex, b->player))
+            bs->hash ^= keys.enpassentFile[bs->enPassentIndex % CSC_FILE_NB];
     }
 
     /* Get the half-move count. */
@@ -164,6 +165,9 @@ struct CSC_Board* CSC_BoardFromFEN(const char* fen)
     token = CSC_Token(NULL, ' ', &state);
     b->turnNumber = atoi(token);
 
+    SetPieceKeys(b, bs);
+    UpdateCheckInfo(b, TopChecks((struct StateStack*)b->states));
+
     free(fenDup);
 
     return b;
@@ -207,10 +211,10 @@ void CSC_FENFromBoard(struct CSC_Board* b, char* buf, int* len)
 
     buf[i++] = ' ';
     start = i;
-    if (bs->castlingRights[CSC_WHITE].kingSide) buf[i++] = 'K';
-    if (bs->castlingRights[CSC_WHITE].queenSide) buf[i++] = 'Q';
-    if (bs->castlingRights[CSC_BLACK].kingSide) buf[i++] = 'k';
-    if (bs->castlingRights[CSC_BLACK].queenSide) buf[i++] = 'q';
+    if (bs->castling & CASTLE_KINGSIDE(CSC_WHITE)) buf[i++] = 'K';
+    if (bs->castling & CASTLE_QUEENSIDE(CSC_WHITE)) buf[i++] = 'Q';
+    if (bs->castling & CASTLE_KINGSIDE(CSC_BLACK)) buf[i++] = 'k';
+    if (bs->castling & CASTLE_QUEENSIDE(CSC_BLACK)) buf[i++] = 'q';
     if (i == start) buf[i++] = '-';
 
     buf[i++] = ' ';
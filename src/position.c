@@ -0,0 +1,158 @@
+#include "chessic.h"
+#include "board.h"
+#include "board_state.h"
+#include "zobrist.h"
+#include "string.h"
+
+void PositionRemovePiece(struct CSC_Position* pos, int loc)
+{
+    int pc = pos->squares[loc];
+    int p = CSC_GetPieceColour(pc);
+    enum CSC_PieceType pt = CSC_GetPieceType(pc);
+
+    CSC_Bitboard bit = (CSC_Bitboard)1 << loc;
+    pos->all[p] ^= bit;
+    pos->pieces[pt][p] ^= bit;
+    pos->squares[loc] = 0;
+
+    pos->hash ^= keys.pieceSquare[p][pt][loc];
+}
+
+void PositionAddPiece(struct CSC_Position* pos, int loc, uint8_t pc)
+{
+    int p = CSC_GetPieceColour(pc);
+    enum CSC_PieceType pt = CSC_GetPieceType(pc);
+
+    CSC_Bitboard bit = (CSC_Bitboard)1 << loc;
+    pos->all[p] |= bit;
+    pos->pieces[pt][p] |= bit;
+    pos->squares[loc] = pc;
+
+    pos->hash ^= keys.pieceSquare[p][pt][loc];
+}
+
+/* This follows CSC_MakeMove so that the positions match the boards. */
+void CSC_PositionMakeMove(
+    const struct CSC_Position* in,
+    CSC_Move m,
+    struct CSC_Position* out)
+{
+    struct CSC_Position pos = *in;
+    int p = pos.player;
+    int s = CSC_GetMoveStart(m);
+    int e = CSC_GetMoveEnd(m);
+    int castleRank = p == CSC_WHITE ? 0 : 7;
+    int rookStartFile, rookEndFile, capLoc;
+    uint8_t sp = pos.squares[s];
+    uint8_t cap = pos.squares[e];
+    enum CSC_PieceType pt = CSC_GetPieceType(sp);
+    enum CSC_MoveType mt = CSC_GetMoveType(m);
+
+    if (PiecesCanCaptureEnPassent(
+            pos.pieces,
+            pos.all[CSC_WHITE] | pos.all[CSC_BLACK],
+            pos.enPassentIndex,
+            p))
+    {
+        pos.hash ^= keys.enpassentFile[pos.enPassentIndex % CSC_FILE_NB];
+    }
+
+    PositionRemovePiece(&pos, s);
+
+    if (mt == CSC_ENPASSENT)
+    {
+        capLoc = e + (p == CSC_WHITE ? -CSC_FILE_NB : CSC_FILE_NB);
+        cap = pos.squares[capLoc];
+        PositionRemovePiece(&pos, capLoc);
+    }
+    else if (cap)
+    {
+        PositionRemovePiece(&pos, e);
+    }
+
+    if (mt == CSC_PROMOTION)
+    {
+        CSC_SetPieceType(&sp, CSC_GetMovePromotion(m));
+    }
+    else if (mt & CSC_CASTLE)
+    {
+        /* Move the corresponding rook. */
+        rookStartFile = mt == CSC_KINGCASTLE ? 7 : 0;
+        rookEndFile = mt == CSC_KINGCASTLE ? 5 : 3;
+
+        PositionAddPiece(
+            &pos,
+            8*castleRank + rookEndFile,
+            pos.squares[8*castleRank + rookStartFile]);
+
+        PositionRemovePiece(&pos, 8*castleRank + rookStartFile);
+    }
+
+    PositionAddPiece(&pos, e, sp);
+
+    pos.castling = CastlingAfterMove(in->castling, p, pt, s, e, cap);
+    pos.hash ^= keys.castlingRights[in->castling ^ pos.castling];
+
+    pos.enPassentIndex = CSC_BAD_LOC;
+    if (mt == CSC_TWOSPACE)
+    {
+        pos.enPassentIndex = e + (p == CSC_WHITE ? -CSC_FILE_NB : CSC_FILE_NB);
+        if (PiecesCanCaptureEnPassent(
+                pos.pieces,
+                pos.all[CSC_WHITE] | pos.all[CSC_BLACK],
+                pos.enPassentIndex,
+                1-p))
+        {
+            pos.hash ^= keys.enpassentFile[e % CSC_FILE_NB];
+        }
+    }
+
+    pos.plies50Move = cap || pt == CSC_PAWN ? 0 : pos.plies50Move + 1;
+
+    pos.player = 1 - p;
+    pos.hash ^= keys.side;
+
+    *out = pos;
+}
+
+void CSC_PositionFromBoard(struct CSC_Board* b, struct CSC_Position* pos)
+{
+    struct BoardState* bs = Top((struct StateStack*)b->states);
+    int i;
+
+    memcpy(pos->all, b->all, sizeof(pos->all));
+    memcpy(pos->pieces, b->pieces, sizeof(pos->pieces));
+
+    for (i = 0; i < CSC_SQUARE_NB; i++) pos->squares[i] = b->squares[i];
+
+    pos->castling = bs->castling;
+    pos->hash = bs->hash;
+    pos->player = b->player;
+    pos->enPassentIndex = bs->enPassentIndex;
+    pos->plies50Move = bs->plies50Move;
+    pos->turnNumber = b->turnNumber;
+}
+
+struct CSC_Board* CSC_BoardFromPosition(const struct CSC_Position* pos)
+{
+    struct CSC_Board* b = CreateBoardEmpty();
+    struct BoardState* bs = Top((struct StateStack*)b->states);
+    int i;
+
+    memcpy(b->all, pos->all, sizeof(b->all));
+    memcpy(b->pieces, pos->pieces, sizeof(b->pieces));
+
+    for (i = 0; i < CSC_SQUARE_NB; i++) b->squares[i] = pos->squares[i];
+
+    b->player = pos->player;
+    b->turnNumber = pos->turnNumber;
+    bs->castling = pos->castling;
+    bs->hash = pos->hash;
+    bs->enPassentIndex = pos->enPassentIndex;
+    bs->plies50Move = pos->plies50Move;
+
+    SetPieceKeys(b, bs);
+    UpdateCheckInfo(b, TopChecks((struct StateStack*)b->states));
+
+    return b;
+}
@@ -0,0 +1,174 @@
+#include "chessic.h"
+
+/* The piece values used by the static exchange evaluation. The king is worth
+   more than everything else combined so that it is never exchanged. */
+const int SEEValues[7] = { 0, 100, 300, 300, 500, 900, 20000 };
+
+/* Find the least valuable of the player's attackers. Returns the piece type
+   (or CSC_NONE if there are no attackers) and sets the location bitboard. */
+enum CSC_PieceType LeastValuableAttacker(
+    struct CSC_Board* b,
+    CSC_Bitboard attackers,
+    int p,
+    CSC_Bitboard* attacker)
+{
+    enum CSC_PieceType pt;
+    CSC_Bitboard bb;
+
+    for (pt = CSC_PAWN; pt <= CSC_KING; pt++)
+    {
+        bb = attackers & b->pieces[pt][p];
+        if (bb)
+        {
+            *attacker = bb & -bb;
+            return pt;
+        }
+    }
+
+    return CSC_NONE;
+}
+
+/* Add the sliders which attack the location through a piece which has just
+   been removed from the occupancy. */
+CSC_Bitboard XRayAttackers(
+    struct CSC_Board* b,
+    int loc,
+    CSC_Bitboard occ,
+    enum CSC_PieceType removed)
+{
+    CSC_Bitboard xrays = 0;
+
+    if (removed == CSC_PAWN || removed == CSC_BISHOP || removed == CSC_QUEEN)
+    {
+        xrays |= CSC_BishopAttacks(loc, occ)
+            & (b->pieces[CSC_BISHOP][CSC_WHITE] | b->pieces[CSC_BISHOP][CSC_BLACK]
+             | b->pieces[CSC_QUEEN][CSC_WHITE] | b->pieces[CSC_QUEEN][CSC_BLACK]);
+    }
+
+    if (removed == CSC_ROOK || removed == CSC_QUEEN)
+    {
+        xrays |= CSC_RookAttacks(loc, occ)
+            & (b->pieces[CSC_ROOK][CSC_WHITE] | b->pieces[CSC_ROOK][CSC_BLACK]
+             | b->pieces[CSC_QUEEN][CSC_WHITE] | b->pieces[CSC_QUEEN][CSC_BLACK]);
+    }
+
+    return xrays & occ;
+}
+
+int CSC_SEE(struct CSC_Board* b, CSC_Move m)
+{
+    int start = CSC_GetMoveStart(m);
+    int end = CSC_GetMoveEnd(m);
+    int type = CSC_GetMoveType(m);
+    int p = b->player;
+    int gain[32], d = 0;
+    CSC_Bitboard occ = b->all[CSC_WHITE] | b->all[CSC_BLACK];
+    CSC_Bitboard attacker = (CSC_Bitboard)1 << start;
+    CSC_Bitboard attackers;
+    enum CSC_PieceType onSquare;
+
+    if (type & CSC_CASTLE) return 0;
+
+    onSquare = CSC_GetPieceType(b->squares[start]);
+
+    if (type == CSC_ENPASSENT)
+    {
+        gain[0] = SEEValues[CSC_PAWN];
+        occ ^= (CSC_Bitboard)1 << (p == CSC_WHITE ? end-CSC_FILE_NB : end+CSC_FILE_NB);
+    }
+    else
+    {
+        gain[0] = SEEValues[CSC_GetPieceType(b->squares[end])];
+    }
+
+    if (type == CSC_PROMOTION)
+    {
+        onSquare = CSC_GetMovePromotion(m);
+        gain[0] += SEEValues[onSquare] - SEEValues[CSC_PAWN];
+    }
+
+    occ ^= attacker;
+    attackers = CSC_AttackersTo(b, end, occ) & occ;
+
+    /* Build up the list of speculative gains assuming that each side keeps
+       recapturing until it runs out of attackers. */
+    for (;;)
+    {
+        d++;
+        gain[d] = SEEValues[onSquare] - gain[d-1];
+
+        p = 1-p;
+        onSquare = LeastValuableAttacker(b, attackers, p, &attacker);
+        if (onSquare == CSC_NONE) break;
+
+        occ ^= attacker;
+        attackers = (attackers & occ) | XRayAttackers(b, end, occ, onSquare);
+    }
+
+    /* Either side can choose to stop capturing. */
+    while (--d)
+    {
+        gain[d-1] = -(-gain[d-1] > gain[d] ? -gain[d-1] : gain[d]);
+    }
+
+    return gain[0];
+}
+
+bool CSC_SEEGreaterOrEqual(
+    struct CSC_Board* b,
+    CSC_Move m,
+    int threshold)
+{
+    int start = CSC_GetMoveStart(m);
+    int end = CSC_GetMoveEnd(m);
+    int p = b->player;
+    int swap;
+    bool res = true;
+    CSC_Bitboard occ, attackers, attacker;
+    enum CSC_PieceType pt;
+
+    if (CSC_GetMoveType(m) & CSC_CASTLE) return threshold <= 0;
+
+    /* The special moves change the material on the end square, so these fall
+       back to the full evaluation. */
+    if (CSC_GetMoveType(m) != CSC_NORMAL && CSC_GetMoveType(m) != CSC_TWOSPACE)
+    {
+        return CSC_SEE(b, m) >= threshold;
+    }
+
+    /* Check whether the side to move is ahead of the threshold if the move is
+       recaptured, and whether it is behind it even if it isn't. */
+    swap = SEEValues[CSC_GetPieceType(b->squares[end])] - threshold;
+    if (swap < 0) return false;
+
+    swap = SEEValues[CSC_GetPieceType(b->squares[start])] - swap;
+    if (swap <= 0) return true;
+
+    occ = (b->all[CSC_WHITE] | b->all[CSC_BLACK]) ^ ((CSC_Bitboard)1 << start);
+    attackers = CSC_AttackersTo(b, end, occ) & occ;
+
+    /* Alternate captures with the least valuable attacker, where swap is the
+       margin that the side which made the last capture needs to keep. */
+    for (;;)
+    {
+        p = 1-p;
+        pt = LeastValuableAttacker(b, attackers, p, &attacker);
+        if (pt == CSC_NONE) break;
+
+        res = !res;
+
+        /* The king can only capture if there are no more enemy attackers. */
+        if (pt == CSC_KING)
+        {
+            return (attackers & b->all[1-p]) ? !res : res;
+        }
+
+        swap = SEEValues[pt] - swap;
+        if (swap < (int)res) break;
+
+        occ ^= attacker;
+        attackers = (attackers & occ) | XRayAttackers(b, end, occ, pt);
+    }
+
+    return res;
+}
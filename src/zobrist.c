@@ -1,7 +1,10 @@
 #include "chessic.h"
 #include "zobrist.h"
+#include "stdlib.h"
+#include "string.h"
 
 struct ZobristKeys keys;
+struct CuckooTable cuckoo;
 
 uint64_t xorshift128plus(uint64_t s[2])
 {
@@ -13,9 +16,80 @@ uint64_t xorshift128plus(uint64_t s[2])
     return s[1] + y;
 }
 
+/* Check whether the piece type can move between the squares on an empty
+   board. This doesn't use the attack tables so that it doesn't depend on them
+   having been initialised. */
+bool CanMoveBetween(enum CSC_PieceType pt, int s1, int s2)
+{
+    int df = abs(s1 % CSC_FILE_NB - s2 % CSC_FILE_NB);
+    int dr = abs(s1 / CSC_FILE_NB - s2 / CSC_FILE_NB);
+
+    if (s1 == s2) return false;
+
+    switch (pt)
+    {
+        case CSC_KNIGHT: return df*dr == 2;
+        case CSC_BISHOP: return df == dr;
+        case CSC_ROOK: return df == 0 || dr == 0;
+        case CSC_QUEEN: return df == dr || df == 0 || dr == 0;
+        case CSC_KING: return df <= 1 && dr <= 1;
+        default: return false;
+    }
+}
+
+/* Fill in the cuckoo table. When the location for a key is taken the key
+   which was there is moved to its other location, and so on until an empty
+   entry is found. */
+void InitCuckoo()
+{
+    int p, pt, s1, s2, i;
+    uint64_t key, tempKey;
+    CSC_Move m, tempMove;
+
+    memset(&cuckoo, 0, sizeof(cuckoo));
+
+    for (p = 0; p < 2; p++)
+    {
+        for (pt = CSC_KNIGHT; pt <= CSC_KING; pt++)
+        {
+            for (s1 = 0; s1 < CSC_SQUARE_NB; s1++)
+            {
+                for (s2 = s1 + 1; s2 < CSC_SQUARE_NB; s2++)
+                {
+                    if (!CanMoveBetween(pt, s1, s2)) continue;
+
+                    key = keys.pieceSquare[p][pt][s1]
+                        ^ keys.pieceSquare[p][pt][s2]
+                        ^ keys.side;
+
+                    m = CSC_CreateMove(s1, s2, 0, CSC_NORMAL);
+
+                    i = CuckooH1(key);
+                    for (;;)
+                    {
+                        tempKey = cuckoo.keys[i];
+                        cuckoo.keys[i] = key;
+                        key = tempKey;
+
+                        tempMove = cuckoo.moves[i];
+                        cuckoo.moves[i] = m;
+                        m = tempMove;
+
+                        if (m == CSC_NO_MOVE) break;
+
+                        i = i == (int)CuckooH1(key)
+                            ? (int)CuckooH2(key)
+                            : (int)CuckooH1(key);
+                    }
+                }
+            }
+        }
+    }
+}
+
 void CSC_InitZobrist()
 {
-    int p, pt, sq, ct, f;
+    int p, pt, sq, ct, f, m;
     uint64_t seed[2] = { 0xDEADBEEF, 0x8BADF00D };
 
     for (p = 0; p < 2; p++)
@@ -40,5 +114,21 @@ void CSC_InitZobrist()
     }
 
     keys.side = xorshift128plus(seed);
+
+    /* Bit 2*p of the mask is the kingside right and bit 2*p+1 the queenside. */
+    for (m = 0; m < 16; m++)
+    {
+        keys.castlingRights[m] = 0;
+        for (p = 0; p < 2; p++)
+        {
+            for (ct = 0; ct < 2; ct++)
+            {
+                if (m & (1 << (2*p + ct)))
+                    keys.castlingRights[m] ^= keys.castling[p][ct];
+            }
+        }
+    }
+
+    InitCuckoo();
 }
 
@@ -13,10 +13,36 @@ struct ZobristKeys
     /* Indexed by: player, king/queenside. */
     uint64_t castling[2][2];
 
+    /* The combined castling keys for each castling rights mask, so that the
+       change in rights can be hashed in one step. */
+    uint64_t castlingRights[16];
+
     /* Alternate each turn. */
     uint64_t side;
 };
 
 extern struct ZobristKeys keys;
 
+/* The material key is the XOR of the keys for each piece that each player has
+   i.e. MaterialKey(p, pt, n) is included if the player has more than n pieces
+   of that type. The piece-square keys are reused for this. */
+#define MaterialKey(p, pt, n) ((uint32_t)keys.pieceSquare[p][pt][n])
+
+/* The size of the cuckoo table (must be a power of 2) and its hash functions. */
+#define CUCKOO_SIZE 8192
+#define CuckooH1(h) ((h) & (CUCKOO_SIZE - 1))
+#define CuckooH2(h) (((h) >> 16) & (CUCKOO_SIZE - 1))
+
+/* The change in the hash for every reversible move (i.e. a move by a piece
+   other than a pawn between two squares it attacks on an empty board), and
+   the move itself. Each key is stored at one of its two hash locations. Empty
+   entries have no move. */
+struct CuckooTable
+{
+    uint64_t keys[CUCKOO_SIZE];
+    CSC_Move moves[CUCKOO_SIZE];
+};
+
+extern struct CuckooTable cuckoo;
+
 #endif /* __CHESSIC_ZOBRIST_H__ */
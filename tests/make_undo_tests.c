@@ -74,11 +74,491 @@ char* MakeUndoTest4()
         "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
 }
 
+/* Check that the checkers found when making a move match the attackers of the
+   king, both after making and after undoing moves. */
+bool CheckersMatch(struct CSC_Board* b)
+{
+    int king = CSC_LSB(b->pieces[CSC_KING][b->player]);
+    CSC_Bitboard checkers = CSC_AttackersTo(
+        b,
+        king,
+        b->all[CSC_WHITE] | b->all[CSC_BLACK]) & b->all[1-b->player];
+
+    return CSC_GetCheckers(b) == checkers
+        && CSC_InCheck(b) == CSC_IsAttacked(b, king);
+}
+
+bool CheckersWalk(struct CSC_Board* b, int depth)
+{
+    struct CSC_MoveList* l;
+    bool match = CheckersMatch(b);
+    int i;
+
+    if (depth == 0 || !match) return match;
+
+    l = CSC_MakeMoveList();
+    CSC_GetMoves(b, l, CSC_ALL);
+    for (i = 0; i < l->n && match; i++)
+    {
+        CSC_MakeMove(b, l->moves[i]);
+        match = CheckersWalk(b, depth-1);
+        CSC_UndoMove(b);
+        match = match && CheckersMatch(b);
+    }
+
+    CSC_FreeMoveList(l);
+
+    return match;
+}
+
+char* CheckersTest(const char* fen)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+
+    printf("Checkers test: %s\n", fen);
+
+    mu_assert("The cached checkers are wrong.", CheckersWalk(b, 3));
+
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* CheckersTest1()
+{
+    return CheckersTest(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+}
+
+char* CheckersTest2()
+{
+    return CheckersTest(
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+}
+
+char* CheckersTest3()
+{
+    return CheckersTest(
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+}
+
+/* Play a long game which makes the history grow (with and without reserving
+   space first), and check that copies of the board keep the full history. */
+char* LongHistoryTest(int reserve)
+{
+    const char* fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    const char* moves[] = { "g1f3", "g8f6", "f3g1", "f6g8" };
+    const char* pawnMoves[] = { "e2e4", "e7e5" };
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_Board* initial = CSC_BoardFromFEN(fen);
+    struct CSC_Board* copy;
+    CSC_Hash hashes[1010];
+    int i, plies = 1010;
+    const char* uci;
+
+    printf("Long history test (reserving %d)\n", reserve);
+
+    if (reserve) CSC_ReserveHistory(b, reserve);
+
+    /* Shuffle the knights, then push the pawns to reset the 50-move counter
+       and repeat the resulting position three times so that only the
+       repetition can make it drawn. */
+    for (i = 0; i < plies; i++)
+    {
+        if (i < 1000) uci = moves[i % 4];
+        else if (i < 1002) uci = pawnMoves[i - 1000];
+        else uci = moves[(i - 1002) % 4];
+
+        hashes[i] = CSC_GetHash(b);
+        CSC_MakeMove(b, CSC_MoveFromUCIString(b, uci));
+
+        if (i == plies - 5)
+        {
+            mu_assert("The position shouldn't be drawn before the third repetition.",
+                !CSC_IsDrawn(b));
+        }
+    }
+
+    copy = CSC_CopyBoard(b);
+    mu_assert("The copied board doesn't match.", CSC_BoardEqual(b, copy));
+    mu_assert("The repetition should be found in the copy.", CSC_IsDrawn(copy));
+
+    for (i = plies - 1; i >= 0; i--)
+    {
+        CSC_UndoMove(copy);
+        mu_assert("The history is wrong in the copy.", CSC_GetHash(copy) == hashes[i]);
+    }
+
+    mu_assert("Undoing all moves in the copy should give the initial board.",
+        CSC_BoardEqual(copy, initial));
+
+    CSC_FreeBoard(copy);
+    CSC_FreeBoard(initial);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* LongHistoryTest1()
+{
+    return LongHistoryTest(0);
+}
+
+char* LongHistoryTest2()
+{
+    return LongHistoryTest(1000);
+}
+
+/* Check that a null move gives the same hash as the position with the other
+   player to move and undoes back to the initial board. */
+char* NullMoveTest(const char* fen, const char* passed)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_Board* initial = CSC_BoardFromFEN(fen);
+    struct CSC_Board* expected = CSC_BoardFromFEN(passed);
+
+    printf("FEN: %s\n", fen);
+
+    CSC_MakeNullMove(b);
+
+    mu_assert("The null move should pass the turn.",
+        b->player == expected->player);
+    mu_assert("The null move should clear the en-passent square.",
+        CSC_GetEnPassentIndex(b) == CSC_BAD_LOC);
+    mu_assert("The hash doesn't match after the null move.",
+        CSC_GetHash(b) == CSC_GetHash(expected));
+
+    CSC_UndoNullMove(b);
+
+    mu_assert("Undoing the null move should give the initial board.",
+        CSC_BoardEqual(b, initial));
+
+    CSC_FreeBoard(expected);
+    CSC_FreeBoard(initial);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* NullMoveTest1()
+{
+    return NullMoveTest(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1");
+}
+
+char* NullMoveTest2()
+{
+    return NullMoveTest(
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 1");
+}
+
+/* Repetitions shouldn't be counted across a null move. */
+char* NullMoveTest3()
+{
+    const char* moves[] = { "g1f3", "g8f6", "f3g1", "f6g8" };
+    struct CSC_Board* b = CSC_BoardFromFEN(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    int i;
+
+    for (i = 0; i < 4; i++)
+        CSC_MakeMove(b, CSC_MoveFromUCIString(b, moves[i]));
+
+    CSC_MakeNullMove(b);
+    CSC_MakeNullMove(b);
+    mu_assert("A repetition was counted across the null moves.", !CSC_IsDrawn(b));
+
+    CSC_UndoNullMove(b);
+    CSC_UndoNullMove(b);
+
+    for (i = 0; i < 4; i++)
+        CSC_MakeMove(b, CSC_MoveFromUCIString(b, moves[i]));
+
+    mu_assert("The repetition should be found after undoing the null moves.",
+        CSC_IsDrawn(b));
+
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+/* Check that the hash after the moves matches the hash of the expected
+   position, e.g. when the en-passent square can't be used or the castling
+   rights have been lost. */
+char* HashTest(const char* fen, const char* moves[], int n, const char* expected)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_Board* e = CSC_BoardFromFEN(expected);
+    int i;
+
+    for (i = 0; i < n; i++)
+        CSC_MakeMove(b, CSC_MoveFromUCIString(b, moves[i]));
+
+    mu_assert("The hash doesn't match the expected position.",
+        CSC_GetHash(b) == CSC_GetHash(e));
+
+    CSC_FreeBoard(e);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* HashTest1()
+{
+    const char* moves[] = { "e2e4" };
+    return HashTest(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        moves, 1,
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+}
+
+char* HashTest2()
+{
+    const char* moves[] = { "e1e2", "e8e7", "e2e1", "e7e8" };
+    return HashTest(
+        "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+        moves, 4,
+        "r3k2r/8/8/8/8/8/8/R3K2R w - - 0 1");
+}
+
+char* HashTest3()
+{
+    const char* moves[] = { "a1a8" };
+    return HashTest(
+        "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+        moves, 1,
+        "R3k2r/8/8/8/8/8/8/4K2R b Kk - 0 1");
+}
+
+char* HashTest4()
+{
+    const char* moves[] = { "d2d4" };
+    return HashTest(
+        "4k3/8/8/8/4p3/8/3P4/K3R3 w - - 0 1",
+        moves, 1,
+        "4k3/8/8/8/3Pp3/8/8/K3R3 b - - 0 1");
+}
+
+char* HashTest5()
+{
+    const char* moves[] = { "d2d4" };
+    return HashTest(
+        "8/8/8/8/k3p2R/8/3P4/4K3 w - - 0 1",
+        moves, 1,
+        "8/8/8/8/k2Pp2R/8/8/4K3 b - - 0 1");
+}
+
+/* Check that the pawn hash only changes when the pawns do, and that the
+   material key only depends on the numbers of pieces. */
+char* PieceKeysTest()
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    struct CSC_Board* e = CSC_BoardFromFEN(
+        "rnbqkb1r/pppppppp/5n2/8/8/5N2/PPPPPPPP/RNBQKB1R w KQkq - 0 1");
+    CSC_Hash pawnHash = CSC_GetPawnHash(b);
+    uint32_t materialKey = CSC_GetMaterialKey(b);
+
+    CSC_MakeMove(b, CSC_MoveFromUCIString(b, "g1f3"));
+    mu_assert("A knight move shouldn't change the pawn hash.",
+        CSC_GetPawnHash(b) == pawnHash);
+    mu_assert("A quiet move shouldn't change the material key.",
+        CSC_GetMaterialKey(b) == materialKey);
+
+    CSC_MakeMove(b, CSC_MoveFromUCIString(b, "e7e5"));
+    mu_assert("A pawn move should change the pawn hash.",
+        CSC_GetPawnHash(b) != pawnHash);
+
+    CSC_MakeMove(b, CSC_MoveFromUCIString(b, "f3e5"));
+    mu_assert("A capture should change the material key.",
+        CSC_GetMaterialKey(b) != materialKey);
+
+    CSC_UndoMove(b);
+    CSC_UndoMove(b);
+    CSC_UndoMove(b);
+    mu_assert("The pawn hash wasn't restored.", CSC_GetPawnHash(b) == pawnHash);
+
+    mu_assert("The same material should have the same key.",
+        CSC_GetMaterialKey(e) == materialKey);
+    mu_assert("The same pawns should have the same pawn hash.",
+        CSC_GetPawnHash(e) == pawnHash);
+
+    CSC_FreeBoard(e);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+/* Check that applying the changes from each move to the previous squares gives
+   the squares after the move. */
+char* DirtyPiecesTest(const char* fen)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    struct CSC_MoveList* replies = CSC_MakeMoveList();
+    const struct CSC_DirtyPieces* dirty;
+    struct CSC_DirtyPieces expected;
+    CSC_Piece squares[CSC_SQUARE_NB];
+    int i, j;
+
+    printf("Dirty pieces test: %s\n", fen);
+
+    mu_assert("There shouldn't be any changes before a move.",
+        CSC_GetLastMoveDelta(b)->n == 0);
+
+    CSC_GetMoves(b, l, CSC_ALL);
+    for (i = 0; i < l->n; i++)
+    {
+        memcpy(squares, b->squares, sizeof(squares));
+
+        CSC_MakeMove(b, l->moves[i]);
+
+        dirty = CSC_GetLastMoveDelta(b);
+        mu_assert("The wrong number of changes.",
+            dirty->n >= 2 && dirty->n <= CSC_MAX_DIRTY_PIECES);
+
+        for (j = 0; j < dirty->n; j++)
+        {
+            if (dirty->added[j])
+            {
+                squares[dirty->locs[j]] = dirty->pieces[j];
+            }
+            else
+            {
+                mu_assert("The removed piece wasn't on the square.",
+                    squares[dirty->locs[j]] == dirty->pieces[j]);
+                squares[dirty->locs[j]] = 0;
+            }
+        }
+
+        mu_assert("The changes don't match the move.",
+            memcmp(squares, b->squares, sizeof(squares)) == 0);
+
+        /* The changes are worked out again after undoing the next move. */
+        memcpy(&expected, dirty, sizeof(expected));
+
+        CSC_GetMoves(b, replies, CSC_ALL);
+        if (replies->n > 0)
+        {
+            CSC_MakeMove(b, replies->moves[0]);
+            CSC_UndoMove(b);
+
+            dirty = CSC_GetLastMoveDelta(b);
+            mu_assert("The number of changes is different after an undo.",
+                dirty->n == expected.n);
+
+            for (j = 0; j < dirty->n; j++)
+            {
+                mu_assert("The changes are different after an undo.",
+                    dirty->pieces[j] == expected.pieces[j]
+                    && dirty->locs[j] == expected.locs[j]
+                    && dirty->added[j] == expected.added[j]);
+            }
+        }
+
+        replies->n = 0;
+
+        CSC_UndoMove(b);
+    }
+
+    CSC_FreeMoveList(replies);
+    CSC_FreeMoveList(l);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* DirtyPiecesTest1()
+{
+    return DirtyPiecesTest(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+}
+
+char* DirtyPiecesTest2()
+{
+    return DirtyPiecesTest("n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1");
+}
+
+char* DirtyPiecesTest3()
+{
+    return DirtyPiecesTest(
+        "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+}
+
+/* Play the moves and check whether the game is drawn after each of them. */
+char* RepetitionTest(const char* fen, const char* moves[], int n, int drawnAt)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    int i;
+
+    printf("Repetition test: %s\n", fen);
+
+    mu_assert("The initial position shouldn't be drawn.", !CSC_IsDrawn(b));
+
+    for (i = 0; i < n; i++)
+    {
+        CSC_MakeMove(b, CSC_MoveFromUCIString(b, moves[i]));
+        mu_assert("The draw was found at the wrong ply.",
+            CSC_IsDrawn(b) == (i + 1 >= drawnAt));
+    }
+
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+/* The first occurrence of the repeated position is straight after a pawn
+   move. */
+char* RepetitionTest1()
+{
+    const char* moves[] = {
+        "e2e4", "e7e5",
+        "g1f3", "g8f6", "f3g1", "f6g8",
+        "g1f3", "g8f6", "f3g1", "f6g8" };
+
+    return RepetitionTest(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        moves, 10, 10);
+}
+
+/* The 50 move counter from the FEN goes further back than the history. */
+char* RepetitionTest2()
+{
+    const char* moves[] = {
+        "g1f3", "g8f6", "f3g1", "f6g8",
+        "g1f3", "g8f6", "f3g1", "e7e5",
+        "g1f3", "f6g8", "f3g1", "g8f6" };
+
+    return RepetitionTest(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 40 20",
+        moves, 12, 13);
+}
+
 char* AllMakeUndoTests()
 {
     mu_run_test(MakeUndoTest1);
     mu_run_test(MakeUndoTest2);
     mu_run_test(MakeUndoTest3);
     mu_run_test(MakeUndoTest4);
+    mu_run_test(CheckersTest1);
+    mu_run_test(CheckersTest2);
+    mu_run_test(CheckersTest3);
+    mu_run_test(LongHistoryTest1);
+    mu_run_test(LongHistoryTest2);
+    mu_run_test(NullMoveTest1);
+    mu_run_test(NullMoveTest2);
+    mu_run_test(NullMoveTest3);
+    mu_run_test(HashTest1);
+    mu_run_test(HashTest2);
+    mu_run_test(HashTest3);
+    mu_run_test(HashTest4);
+    mu_run_test(HashTest5);
+    mu_run_test(PieceKeysTest);
+    mu_run_test(DirtyPiecesTest1);
+    mu_run_test(DirtyPiecesTest2);
+    mu_run_test(DirtyPiecesTest3);
+    mu_run_test(RepetitionTest1);
+    mu_run_test(RepetitionTest2);
     return NULL;
 }
@@ -35,6 +35,7 @@ char* MoveGenTestSingleType(
     free(buf);
 
     mu_assert("Wrong number of moves generated.", l->n == expected);
+    mu_assert("Wrong number of moves counted.", CSC_CountMoves(b, type) == expected);
 
     return NULL;
 }
@@ -122,6 +123,266 @@ char* MoveGenTest5()
         32, 2, 34);
 }
 
+/* Black is in check from a pawn which can be captured en-passent. */
+char* MoveGenTestEvasions1()
+{
+    return MoveGenTest(
+        "8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1",
+        7, 2, 9);
+}
+
+/* White is in double check so only the king can move (capturing the rook). */
+char* MoveGenTestEvasions2()
+{
+    return MoveGenTest(
+        "4k3/8/8/8/8/8/4r3/R3K2r w - - 0 1",
+        0, 1, 1);
+}
+
+/* Count the quiet moves which give check by making each one. */
+int CountQuietChecks(struct CSC_Board* b)
+{
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    int i, checks = 0;
+
+    CSC_GetMoves(b, l, CSC_QUIETS);
+    for (i = 0; i < l->n; i++)
+    {
+        CSC_MakeMove(b, l->moves[i]);
+        checks += CSC_IsAttacked(b, CSC_LSB(b->pieces[CSC_KING][b->player]));
+        CSC_UndoMove(b);
+    }
+
+    CSC_FreeMoveList(l);
+
+    return checks;
+}
+
+/* Check that the quiet check generation matches making each quiet move, both
+   in the position and after each of the moves from it. */
+char* MoveGenQuietChecksTest(const char* fen)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    struct CSC_MoveList* checks = CSC_MakeMoveList();
+    int i, expected, captures;
+
+    printf("Quiet checks test: %s\n", fen);
+
+    CSC_GetMoves(b, l, CSC_ALL);
+    for (i = -1; i < l->n; i++)
+    {
+        if (i >= 0) CSC_MakeMove(b, l->moves[i]);
+
+        expected = CountQuietChecks(b);
+        captures = CSC_CountMoves(b, CSC_CAPTURES);
+
+        checks->n = 0;
+        CSC_GetMoves(b, checks, CSC_QUIET_CHECKS);
+        mu_assert("Wrong number of quiet checks generated.", checks->n == expected);
+
+        mu_assert("Wrong number of quiet checks counted.",
+            CSC_CountMoves(b, CSC_QUIET_CHECKS) == expected);
+
+        mu_assert("Wrong number of captures and quiet checks counted.",
+            CSC_CountMoves(b, CSC_CAPTURES | CSC_QUIET_CHECKS) == expected + captures);
+
+        if (i >= 0) CSC_UndoMove(b);
+    }
+
+    CSC_FreeMoveList(checks);
+    CSC_FreeMoveList(l);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* MoveGenQuietChecksTest1()
+{
+    return MoveGenQuietChecksTest(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+}
+
+char* MoveGenQuietChecksTest2()
+{
+    /* Discovered checks along the rank. */
+    return MoveGenQuietChecksTest(
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+}
+
+char* MoveGenQuietChecksTest3()
+{
+    /* Promotions. */
+    return MoveGenQuietChecksTest(
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+}
+
+char* MoveGenQuietChecksTest4()
+{
+    /* Castling and promoting with check. */
+    return MoveGenQuietChecksTest(
+        "5k2/1P6/8/8/8/8/8/4K2R w K - 0 1");
+}
+
+char* MoveGenQuietChecksTest5()
+{
+    /* Discovered checks by moving the king or pawns. */
+    return MoveGenQuietChecksTest(
+        "4k3/8/2P5/8/B7/4K3/8/4R3 w - - 0 1");
+}
+
+/* Check that CSC_GivesCheck agrees with making each move, both in the
+   position and after each of the moves from it. */
+char* GivesCheckTest(const char* fen)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    struct CSC_MoveList* children = CSC_MakeMoveList();
+    bool check;
+    int i, j;
+
+    printf("Gives check test: %s\n", fen);
+
+    CSC_GetMoves(b, children, CSC_ALL);
+    for (i = -1; i < children->n; i++)
+    {
+        if (i >= 0) CSC_MakeMove(b, children->moves[i]);
+
+        l->n = 0;
+        CSC_GetMoves(b, l, CSC_ALL);
+        for (j = 0; j < l->n; j++)
+        {
+            check = CSC_GivesCheck(b, l->moves[j]);
+
+            CSC_MakeMove(b, l->moves[j]);
+            mu_assert("Incorrect gives check result.", check == CSC_InCheck(b));
+            CSC_UndoMove(b);
+        }
+
+        if (i >= 0) CSC_UndoMove(b);
+    }
+
+    CSC_FreeMoveList(children);
+    CSC_FreeMoveList(l);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* GivesCheckTest1()
+{
+    return GivesCheckTest(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+}
+
+char* GivesCheckTest2()
+{
+    return GivesCheckTest(
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+}
+
+char* GivesCheckTest3()
+{
+    return GivesCheckTest(
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+}
+
+char* GivesCheckTest4()
+{
+    /* En-passent discovers a check along the rank. */
+    return GivesCheckTest("8/8/8/1k1pP2R/8/8/8/4K3 w - d6 0 1");
+}
+
+char* GivesCheckTest5()
+{
+    /* Castling and promoting with check (and after the replies). */
+    return GivesCheckTest("3k4/1P6/8/8/8/8/8/R3K2R w KQ - 0 1");
+}
+
+/* Check that a move is pseudo-legal and legal exactly when it is generated,
+   trying every start, end, promotion and move type. */
+bool PseudoLegalMatches(struct CSC_Board* b)
+{
+    static const int types[] =
+    {
+        CSC_NORMAL, CSC_TWOSPACE, CSC_PROMOTION, CSC_ENPASSENT,
+        CSC_KINGCASTLE, CSC_QUEENCASTLE
+    };
+
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    bool generated, match = true;
+    int s, e, t, promo, i;
+    CSC_Move m;
+
+    CSC_GetMoves(b, l, CSC_ALL);
+
+    for (s = 0; s < CSC_SQUARE_NB; s++)
+    for (e = 0; e < CSC_SQUARE_NB; e++)
+    for (t = 0; t < 6; t++)
+    for (promo = CSC_NONE; promo <= CSC_KING; promo++)
+    {
+        m = CSC_CreateMove(s, e, promo, types[t]);
+
+        generated = false;
+        for (i = 0; i < l->n; i++) generated |= l->moves[i] == m;
+
+        match &= generated == (CSC_IsPseudoLegal(b, m) && CSC_IsLegal(b, m));
+    }
+
+    /* Stray bits outside of the move fields are rejected. */
+    for (i = 0; i < l->n; i++)
+    {
+        match &= !CSC_IsPseudoLegal(b, l->moves[i] | ((CSC_Move)1 << 21));
+    }
+
+    CSC_FreeMoveList(l);
+
+    return match;
+}
+
+char* PseudoLegalTest(const char* fen)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    int i;
+
+    printf("Pseudo-legal test: %s\n", fen);
+
+    CSC_GetMoves(b, l, CSC_ALL);
+    for (i = -1; i < l->n; i++)
+    {
+        if (i >= 0) CSC_MakeMove(b, l->moves[i]);
+
+        mu_assert("Pseudo-legal moves don't match the generated moves.",
+            PseudoLegalMatches(b));
+
+        if (i >= 0) CSC_UndoMove(b);
+    }
+
+    CSC_FreeMoveList(l);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* PseudoLegalTest1()
+{
+    return PseudoLegalTest(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+}
+
+char* PseudoLegalTest2()
+{
+    return PseudoLegalTest(
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+}
+
+char* PseudoLegalTest3()
+{
+    return PseudoLegalTest(
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+}
+
 /* In this test I use the starting position and repeatedly move knights until the game should be drawn by repetition. In this situation no moves should
    be generated. */
 char* MoveGenTestDrawByRepetition1()
@@ -155,6 +416,8 @@ char* MoveGenTestDrawByRepetition1()
 
     CSC_GetMoves(b, l, CSC_ALL);
     mu_assert("No moves should be available because the game is drawn", l->n == 0);
+    mu_assert("No moves should be counted because the game is drawn",
+        CSC_CountMoves(b, CSC_ALL) == 0);
 
     CSC_FreeMoveList(l);
     CSC_FreeBoard(b);
@@ -169,6 +432,21 @@ char* AllMoveGenTests()
     mu_run_test(MoveGenTest3);
     mu_run_test(MoveGenTest4);
     mu_run_test(MoveGenTest5);
+    mu_run_test(MoveGenTestEvasions1);
+    mu_run_test(MoveGenTestEvasions2);
+    mu_run_test(MoveGenQuietChecksTest1);
+    mu_run_test(MoveGenQuietChecksTest2);
+    mu_run_test(MoveGenQuietChecksTest3);
+    mu_run_test(MoveGenQuietChecksTest4);
+    mu_run_test(MoveGenQuietChecksTest5);
+    mu_run_test(GivesCheckTest1);
+    mu_run_test(GivesCheckTest2);
+    mu_run_test(GivesCheckTest3);
+    mu_run_test(GivesCheckTest4);
+    mu_run_test(GivesCheckTest5);
+    mu_run_test(PseudoLegalTest1);
+    mu_run_test(PseudoLegalTest2);
+    mu_run_test(PseudoLegalTest3);
     mu_run_test(MoveGenTestDrawByRepetition1);
     return NULL;
 }
@@ -0,0 +1,160 @@
+#include "chessic.h"
+#include "movepicker_tests.h"
+#include "minunit.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+/* Check that the picker returns exactly the moves from CSC_GetMoves, with the
+   hash move first (if it's legal), then the captures which don't lose
+   material, the quiet moves and then the losing captures. */
+char* MovePickerTest(
+    struct CSC_Board* b,
+    CSC_Move hashMove,
+    CSC_Move* killers)
+{
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    struct CSC_MovePicker mp;
+    CSC_Move m;
+    bool* found;
+    bool seenQuiet = false, seenBad = false, capture, hashLegal = false;
+    int i, n = 0, idx;
+
+    CSC_GetMoves(b, l, CSC_ALL);
+    found = calloc(l->n, sizeof(bool));
+
+    for (i = 0; i < l->n; i++) hashLegal |= l->moves[i] == hashMove;
+
+    CSC_InitMovePicker(&mp, b, hashMove, killers);
+    while ((m = CSC_NextMove(&mp)) != CSC_NO_MOVE)
+    {
+        if (n++ == 0 && hashLegal)
+        {
+            mu_assert("The hash move should be returned first.", m == hashMove);
+        }
+
+        idx = -1;
+        for (i = 0; i < l->n; i++)
+        {
+            if (l->moves[i] == m) idx = i;
+        }
+
+        mu_assert("The picker returned an illegal move.", idx >= 0);
+        mu_assert("The picker returned a move twice.", !found[idx]);
+        found[idx] = true;
+
+        /* The hash move and killers can come out of order. */
+        if (m != hashMove
+         && (killers == NULL || (m != killers[0] && m != killers[1])))
+        {
+            capture = b->squares[CSC_GetMoveEnd(m)] != 0
+                || CSC_GetMoveType(m) == CSC_ENPASSENT;
+
+            if (capture && !CSC_SEEGreaterOrEqual(b, m, 0))
+            {
+                seenBad = true;
+            }
+            else
+            {
+                mu_assert("Losing captures should come last.", !seenBad);
+                mu_assert("Captures should come before quiets.",
+                    !(capture && seenQuiet));
+                seenQuiet |= !capture;
+            }
+        }
+    }
+
+    mu_assert("The picker missed some moves.", n == l->n);
+
+    free(found);
+    CSC_FreeMoveList(l);
+
+    return NULL;
+}
+
+char* MovePickerTestPosition(
+    const char* fen,
+    const char* hashMove,
+    const char* killer1,
+    const char* killer2)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    CSC_Move killers[CSC_NUM_KILLERS];
+    char* res;
+
+    printf("Move picker test: %s\n", fen);
+
+    killers[0] = killer1 ? CSC_MoveFromUCIString(b, killer1) : CSC_NO_MOVE;
+    killers[1] = killer2 ? CSC_MoveFromUCIString(b, killer2) : CSC_NO_MOVE;
+
+    res = MovePickerTest(
+        b,
+        hashMove ? CSC_MoveFromUCIString(b, hashMove) : CSC_NO_MOVE,
+        killers);
+
+    if (res == NULL) res = MovePickerTest(b, CSC_NO_MOVE, NULL);
+
+    CSC_FreeBoard(b);
+
+    return res;
+}
+
+char* MovePickerTest1()
+{
+    /* Legal quiet hash move and killers. */
+    return MovePickerTestPosition(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "e1g1", "a2a4", "d5d6");
+}
+
+char* MovePickerTest2()
+{
+    /* Capture as the hash move and as a killer. */
+    return MovePickerTestPosition(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "e5f7", "d5e6", "d5e6");
+}
+
+char* MovePickerTest3()
+{
+    /* Illegal hash move and killers (moving an enemy piece and moving through
+       other pieces). */
+    return MovePickerTestPosition(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "a8a1", "a1a8", "a1a3");
+}
+
+char* MovePickerTest4()
+{
+    /* In check with a killer which doesn't get out of check. */
+    return MovePickerTestPosition(
+        "8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1",
+        "e4d3", "e4e3", "c5b4");
+}
+
+char* MovePickerTest5()
+{
+    /* The queen capturing the defended pawn comes after the killer and the
+       quiet moves. */
+    return MovePickerTestPosition(
+        "4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1",
+        NULL, "e1f1", NULL);
+}
+
+char* MovePickerTest6()
+{
+    /* Winning, equal and losing captures. */
+    return MovePickerTestPosition(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        NULL, "a2a4", NULL);
+}
+
+char* AllMovePickerTests()
+{
+    mu_run_test(MovePickerTest1);
+    mu_run_test(MovePickerTest2);
+    mu_run_test(MovePickerTest3);
+    mu_run_test(MovePickerTest4);
+    mu_run_test(MovePickerTest5);
+    mu_run_test(MovePickerTest6);
+    return NULL;
+}
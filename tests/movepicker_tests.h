@@ -0,0 +1,6 @@
+#ifndef __MOVEPICKER_TESTS_H__
+#define __MOVEPICKER_TESTS_H__
+
+char* AllMovePickerTests();
+
+#endif /* __MOVEPICKER_TESTS_H__ */
@@ -69,10 +69,13 @@ int Perft(struct CSC_Board* b, int depth)
 
     if (depth == 0) return 1;
 
+    /* At the last ply we only need the number of moves. */
+    if (depth == 1) return CSC_CountMovesNoDrawCheck(b, CSC_ALL);
+
     l = list_per_depth[depth - 1];
     l->n = 0;
 
-    CSC_GetMoves(b, l, CSC_ALL);
+    CSC_GetMovesNoDrawCheck(b, l, CSC_ALL);
     for (i = 0; i < l->n; i++)
     {
         m = l->moves[i];
@@ -121,6 +124,209 @@ char* PerftTest()
     return NULL;
 }
 
+/* Check that the hashes after each move match the hashes of the same position
+   read from scratch (via its FEN). */
+bool HashesMatch(struct CSC_Board* b, int depth)
+{
+    struct CSC_MoveList* l;
+    struct CSC_Board* fromScratch;
+    char fen[CSC_MAX_FEN_LENGTH];
+    bool match;
+    int i;
+
+    CSC_FENFromBoard(b, fen, NULL);
+    fromScratch = CSC_BoardFromFEN(fen);
+    match = CSC_GetHash(b) == CSC_GetHash(fromScratch)
+        && CSC_GetPawnHash(b) == CSC_GetPawnHash(fromScratch)
+        && CSC_GetMaterialKey(b) == CSC_GetMaterialKey(fromScratch);
+    CSC_FreeBoard(fromScratch);
+
+    if (!match) printf("Hash mismatch: %s\n", fen);
+    if (!match || depth == 0) return match;
+
+    l = list_per_depth[depth - 1];
+    l->n = 0;
+
+    CSC_GetMovesNoDrawCheck(b, l, CSC_ALL);
+    for (i = 0; i < l->n && match; i++)
+    {
+        CSC_MakeMove(b, l->moves[i]);
+        match = HashesMatch(b, depth-1);
+        CSC_UndoMove(b);
+    }
+
+    return match;
+}
+
+char* PerftHashTest()
+{
+    const int depth = 3;
+    struct TestCase test = testCases[currentTest];
+    struct CSC_Board* b;
+    bool match;
+    int i;
+
+    printf("Hash test: %s\n", test.fen);
+
+    list_per_depth = malloc(depth * sizeof(struct CSC_MoveList*));
+    for (i = 0; i < depth; i++)
+    {
+        list_per_depth[i] = CSC_MakeMoveList();
+    }
+
+    b = CSC_BoardFromFEN(test.fen);
+    match = HashesMatch(b, depth);
+    mu_assert("The incremental hash doesn't match the hash from scratch", match);
+    CSC_FreeBoard(b);
+
+    for (i = 0; i < depth; i++)
+    {
+      CSC_FreeMoveList(list_per_depth[i]);
+    }
+
+    free(list_per_depth);
+
+    return NULL;
+}
+
+#define PLAYOUT_LENGTH 60
+
+/* The hashes and 50 move counters of the positions in the current playout. */
+CSC_Hash playoutHashes[PLAYOUT_LENGTH + 1];
+int playoutPlies50Move[PLAYOUT_LENGTH + 1];
+
+/* Check whether the position at the index repeats an earlier position. */
+bool PlayoutRepeats(int index)
+{
+    int plies;
+    for (plies = 4; plies <= playoutPlies50Move[index] && plies <= index; plies += 2)
+    {
+        if (playoutHashes[index - plies] == playoutHashes[index]) return true;
+    }
+
+    return false;
+}
+
+/* Try all of the reversible moves for the player to move (i.e. non-pawn moves
+   to empty squares, legal or not) and check whether any of them repeat an
+   earlier position in the playout. */
+bool UpcomingRepetitionBruteForce(struct CSC_Board* b, int index, int ply)
+{
+    CSC_Bitboard occ = b->all[CSC_WHITE] | b->all[CSC_BLACK];
+    CSC_Bitboard pieces, targets;
+    CSC_Hash hash;
+    int pt, s, e, plies;
+    bool found = false;
+
+    for (pt = CSC_KNIGHT; pt <= CSC_KING && !found; pt++)
+    {
+        pieces = b->pieces[pt][b->player];
+        while (pieces && !found)
+        {
+            s = CSC_PopLSB(&pieces);
+
+            switch (pt)
+            {
+                case CSC_KNIGHT: targets = CSC_KnightAttacks[s]; break;
+                case CSC_BISHOP: targets = CSC_BishopAttacks(s, occ); break;
+                case CSC_ROOK: targets = CSC_RookAttacks(s, occ); break;
+                case CSC_QUEEN:
+                    targets = CSC_BishopAttacks(s, occ) | CSC_RookAttacks(s, occ);
+                    break;
+                default: targets = CSC_KingAttacks[s]; break;
+            }
+
+            targets &= ~occ;
+            while (targets && !found)
+            {
+                e = CSC_PopLSB(&targets);
+
+                CSC_MakeMove(b, CSC_CreateMove(s, e, 0, CSC_NORMAL));
+                hash = CSC_GetHash(b);
+                CSC_UndoMove(b);
+
+                /* The earlier position is plies+1 plies before the new one. */
+                for (plies = 3; plies <= playoutPlies50Move[index] && plies <= index; plies += 2)
+                {
+                    if (playoutHashes[index - plies] == hash
+                        && (ply > plies || PlayoutRepeats(index - plies)))
+                    {
+                        found = true;
+                    }
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+/* Play random games from the position (preferring reversible moves so that
+   there are repetitions) and check for upcoming repetitions at each ply both
+   within and before the root of a search. */
+char* UpcomingRepetitionTest()
+{
+    const int numPlayouts = 4;
+    const int plies[] = { 0, 6, PLAYOUT_LENGTH };
+    struct TestCase test = testCases[currentTest];
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    struct CSC_MoveList* reversible = CSC_MakeMoveList();
+    struct CSC_Board* b;
+    CSC_Move m;
+    int playout, index, i;
+
+    printf("Upcoming repetition test: %s\n", test.fen);
+
+    srand(currentTest);
+
+    for (playout = 0; playout < numPlayouts; playout++)
+    {
+        b = CSC_BoardFromFEN(test.fen);
+
+        for (index = 0; index <= PLAYOUT_LENGTH; index++)
+        {
+            playoutHashes[index] = CSC_GetHash(b);
+            playoutPlies50Move[index] = CSC_GetPlies50Move(b);
+
+            for (i = 0; i < 3; i++)
+            {
+                mu_assert("The upcoming repetition doesn't match brute force",
+                    CSC_HasUpcomingRepetition(b, plies[i])
+                        == UpcomingRepetitionBruteForce(b, index, plies[i]));
+            }
+
+            l->n = 0;
+            reversible->n = 0;
+            CSC_GetMovesNoDrawCheck(b, l, CSC_ALL);
+            if (l->n == 0) break;
+
+            for (i = 0; i < l->n; i++)
+            {
+                m = l->moves[i];
+                if (CSC_GetMoveType(m) == CSC_NORMAL
+                    && !b->squares[CSC_GetMoveEnd(m)]
+                    && CSC_GetPieceType(b->squares[CSC_GetMoveStart(m)]) != CSC_PAWN)
+                {
+                    CSC_AddMove(reversible, m);
+                }
+            }
+
+            m = reversible->n > 0 && rand() % 10
+                ? reversible->moves[rand() % reversible->n]
+                : l->moves[rand() % l->n];
+
+            CSC_MakeMove(b, m);
+        }
+
+        CSC_FreeBoard(b);
+    }
+
+    CSC_FreeMoveList(reversible);
+    CSC_FreeMoveList(l);
+
+    return NULL;
+}
+
 char* AllPerftTests()
 {
     time_t start;
@@ -133,6 +339,17 @@ char* AllPerftTests()
         mu_run_test(PerftTest);
     }
 
+    /* The test cases for each position start at depth 1. */
+    for (currentTest = 0; currentTest < numTestCases; currentTest++)
+    {
+        if (testCases[currentTest].depth == 1) mu_run_test(PerftHashTest);
+    }
+
+    for (currentTest = 0; currentTest < numTestCases; currentTest++)
+    {
+        if (testCases[currentTest].depth == 1) mu_run_test(UpcomingRepetitionTest);
+    }
+
     printf("Time taken: %lds\n", (time(NULL) - start));
 
     free(testCases);
@@ -0,0 +1,123 @@
+#include "chessic.h"
+#include "position_tests.h"
+#include "minunit.h"
+#include "stdio.h"
+#include "string.h"
+
+bool PositionsEqual(const struct CSC_Position* a, const struct CSC_Position* b)
+{
+    return memcmp(a->all, b->all, sizeof(a->all)) == 0
+        && memcmp(a->pieces, b->pieces, sizeof(a->pieces)) == 0
+        && memcmp(a->squares, b->squares, sizeof(a->squares)) == 0
+        && a->hash == b->hash
+        && a->player == b->player
+        && a->castling == b->castling
+        && a->enPassentIndex == b->enPassentIndex
+        && a->plies50Move == b->plies50Move
+        && a->turnNumber == b->turnNumber;
+}
+
+/* Check that making moves in positions matches making them on the board, for
+   all moves to the given depth. */
+bool PositionWalk(struct CSC_Board* b, const struct CSC_Position* pos, int depth)
+{
+    struct CSC_MoveList* l;
+    struct CSC_Position expected, child;
+    bool match;
+    int i;
+
+    CSC_PositionFromBoard(b, &expected);
+    match = PositionsEqual(&expected, pos);
+
+    if (depth == 0 || !match) return match;
+
+    l = CSC_MakeMoveList();
+    CSC_GetMoves(b, l, CSC_ALL);
+    for (i = 0; i < l->n && match; i++)
+    {
+        CSC_PositionMakeMove(pos, l->moves[i], &child);
+        CSC_MakeMove(b, l->moves[i]);
+        match = PositionWalk(b, &child, depth-1);
+        CSC_UndoMove(b);
+    }
+
+    CSC_FreeMoveList(l);
+
+    return match;
+}
+
+char* PositionMakeMoveTest(const char* fen)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_Position pos;
+
+    printf("Position make move test: %s\n", fen);
+
+    CSC_PositionFromBoard(b, &pos);
+
+    mu_assert("Making moves in the position doesn't match the board.",
+        PositionWalk(b, &pos, 3));
+
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* PositionMakeMoveTest1()
+{
+    return PositionMakeMoveTest(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+}
+
+char* PositionMakeMoveTest2()
+{
+    return PositionMakeMoveTest(
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+}
+
+char* PositionMakeMoveTest3()
+{
+    return PositionMakeMoveTest(
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+}
+
+/* Check that converting a board to a position and back gives the same board. */
+char* PositionRoundTripTest()
+{
+    const char* fen =
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_Board* copy;
+    struct CSC_Position pos;
+    char before[CSC_MAX_FEN_LENGTH], after[CSC_MAX_FEN_LENGTH];
+
+    CSC_MakeMove(b, CSC_MoveFromUCIString(b, "a2a4"));
+
+    CSC_PositionFromBoard(b, &pos);
+    copy = CSC_BoardFromPosition(&pos);
+
+    CSC_FENFromBoard(b, before, NULL);
+    CSC_FENFromBoard(copy, after, NULL);
+
+    printf("Position round trip test: %s\n", after);
+
+    mu_assert("The board is different after converting to a position.",
+        CSC_BoardEqual(b, copy) && strcmp(before, after) == 0);
+
+    mu_assert("The check status is different after converting to a position.",
+        CSC_GetCheckers(b) == CSC_GetCheckers(copy));
+
+    CSC_FreeBoard(copy);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* AllPositionTests()
+{
+    mu_run_test(PositionMakeMoveTest1);
+    mu_run_test(PositionMakeMoveTest2);
+    mu_run_test(PositionMakeMoveTest3);
+    mu_run_test(PositionRoundTripTest);
+    return NULL;
+}
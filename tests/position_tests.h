@@ -0,0 +1,6 @@
+#ifndef __POSITION_TESTS_H__
+#define __POSITION_TESTS_H__
+
+char* AllPositionTests();
+
+#endif /* __POSITION_TESTS_H__ */
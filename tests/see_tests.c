@@ -0,0 +1,146 @@
+#include "chessic.h"
+#include "see_tests.h"
+#include "minunit.h"
+#include "stdio.h"
+
+char* SEETest(const char* fen, const char* uci, int expected)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    CSC_Move m = CSC_MoveFromUCIString(b, uci);
+    int see = CSC_SEE(b, m);
+
+    printf("SEE test: %s %s: %d\n", fen, uci, see);
+
+    mu_assert("Incorrect static exchange evaluation.", see == expected);
+    mu_assert("Threshold at the exchange value should pass.",
+        CSC_SEEGreaterOrEqual(b, m, expected));
+    mu_assert("Threshold above the exchange value should fail.",
+        !CSC_SEEGreaterOrEqual(b, m, expected + 1));
+
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* SEETestUndefended()
+{
+    return SEETest("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", 100);
+}
+
+char* SEETestDefended()
+{
+    return SEETest("4k3/8/3p4/4p3/8/8/8/4RK2 w - - 0 1", "e1e5", -400);
+}
+
+char* SEETestRecapture()
+{
+    /* Recapturing the pawn limits the loss even though it's still negative. */
+    return SEETest("4k3/3p4/8/3PN3/8/8/8/4K3 w - - 0 1", "e5c6", -200);
+}
+
+char* SEETestXRay()
+{
+    /* The rook on e1 recaptures through the rook on e2. */
+    return SEETest("4k3/4r3/8/4p3/8/8/4R3/4RK2 w - - 0 1", "e2e5", 100);
+}
+
+char* SEETestExchange()
+{
+    /* The knight is lost for a pawn after the exchanges on e5. */
+    return SEETest(
+        "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5", -200);
+}
+
+char* SEETestEnPassent()
+{
+    return SEETest("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", 100);
+}
+
+char* SEETestPromotion()
+{
+    return SEETest("1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7b8q", 1300);
+}
+
+char* SEETestQuiet()
+{
+    /* Moving the queen to a square attacked by a pawn loses it. */
+    return SEETest("4k3/8/3p4/8/8/8/8/4QK2 w - - 0 1", "e1e5", -900);
+}
+
+/* Check that the threshold test agrees with the full evaluation for all moves
+   in the position and after each move from it. */
+char* SEEThresholdTest(const char* fen)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    struct CSC_MoveList* children = CSC_MakeMoveList();
+    int i, j, see, threshold;
+
+    printf("SEE threshold test: %s\n", fen);
+
+    CSC_GetMoves(b, children, CSC_ALL);
+    for (i = -1; i < children->n; i++)
+    {
+        if (i >= 0) CSC_MakeMove(b, children->moves[i]);
+
+        l->n = 0;
+        CSC_GetMoves(b, l, CSC_ALL);
+        for (j = 0; j < l->n; j++)
+        {
+            see = CSC_SEE(b, l->moves[j]);
+            for (threshold = -1000; threshold <= 1000; threshold += 50)
+            {
+                mu_assert("The threshold test disagrees with the evaluation.",
+                    CSC_SEEGreaterOrEqual(b, l->moves[j], threshold)
+                        == (see >= threshold));
+            }
+
+            mu_assert("The threshold test disagrees with the evaluation.",
+                CSC_SEEGreaterOrEqual(b, l->moves[j], see)
+             && !CSC_SEEGreaterOrEqual(b, l->moves[j], see + 1));
+        }
+
+        if (i >= 0) CSC_UndoMove(b);
+    }
+
+    CSC_FreeMoveList(children);
+    CSC_FreeMoveList(l);
+    CSC_FreeBoard(b);
+
+    return NULL;
+}
+
+char* SEEThresholdTest1()
+{
+    return SEEThresholdTest(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+}
+
+char* SEEThresholdTest2()
+{
+    return SEEThresholdTest(
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+}
+
+char* SEEThresholdTest3()
+{
+    return SEEThresholdTest(
+        "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1");
+}
+
+char* AllSEETests()
+{
+    printf("Running SEE tests...\n");
+    mu_run_test(SEETestUndefended);
+    mu_run_test(SEETestDefended);
+    mu_run_test(SEETestRecapture);
+    mu_run_test(SEETestXRay);
+    mu_run_test(SEETestExchange);
+    mu_run_test(SEETestEnPassent);
+    mu_run_test(SEETestPromotion);
+    mu_run_test(SEETestQuiet);
+    mu_run_test(SEEThresholdTest1);
+    mu_run_test(SEEThresholdTest2);
+    mu_run_test(SEEThresholdTest3);
+    return NULL;
+}
@@ -0,0 +1,6 @@
+#ifndef __SEE_TESTS_H__
+#define __SEE_TESTS_H__
+
+char* AllSEETests();
+
+#endif /* __SEE_TESTS_H__ */
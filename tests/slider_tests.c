@@ -0,0 +1,169 @@
+#include "chessic.h"
+#include "slider_tests.h"
+#include "minunit.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+#define NUM_BACKENDS 3
+#define NUM_OCCUPANCIES 1000
+
+const char* backendNames[NUM_BACKENDS] = { "ray scan", "magic", "pext" };
+
+int SliderPerft(struct CSC_Board* b, struct CSC_MoveList** lists, int depth)
+{
+    struct CSC_MoveList* l;
+    int nodes = 0, i;
+
+    if (depth == 0) return 1;
+
+    l = lists[depth - 1];
+    l->n = 0;
+
+    CSC_GetMoves(b, l, CSC_ALL);
+    for (i = 0; i < l->n; i++)
+    {
+        CSC_MakeMove(b, l->moves[i]);
+        nodes += SliderPerft(b, lists, depth-1);
+        CSC_UndoMove(b);
+    }
+
+    return nodes;
+}
+
+char* SliderBackendPerftTest(const char* fen, int depth, int expected)
+{
+    enum CSC_SliderBackend original = CSC_GetSliderBackend();
+    struct CSC_MoveList* lists[8];
+    struct CSC_Board* b;
+    int backend, nodes, i;
+    bool match = true;
+
+    printf("Slider backend perft test: %s\n", fen);
+
+    for (i = 0; i < depth; i++) lists[i] = CSC_MakeMoveList();
+
+    for (backend = 0; backend < NUM_BACKENDS && match; backend++)
+    {
+        /* Not all backends are supported on all machines. */
+        if (!CSC_SetSliderBackend((enum CSC_SliderBackend)backend)) continue;
+
+        b = CSC_BoardFromFEN(fen);
+        nodes = SliderPerft(b, lists, depth);
+        CSC_FreeBoard(b);
+
+        printf("Backend %s: %d\n", backendNames[backend], nodes);
+
+        match = nodes == expected;
+    }
+
+    for (i = 0; i < depth; i++) CSC_FreeMoveList(lists[i]);
+
+    CSC_SetSliderBackend(original);
+
+    mu_assert("Backends do not agree on perft count.", match);
+
+    return NULL;
+}
+
+/* These are the six standard perft positions. */
+char* SliderBackendPerftTest1()
+{
+    return SliderBackendPerftTest(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        4, 197281);
+}
+
+char* SliderBackendPerftTest2()
+{
+    return SliderBackendPerftTest(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        3, 97862);
+}
+
+char* SliderBackendPerftTest3()
+{
+    return SliderBackendPerftTest(
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        5, 674624);
+}
+
+char* SliderBackendPerftTest4()
+{
+    return SliderBackendPerftTest(
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        4, 422333);
+}
+
+char* SliderBackendPerftTest5()
+{
+    return SliderBackendPerftTest(
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        3, 62379);
+}
+
+char* SliderBackendPerftTest6()
+{
+    return SliderBackendPerftTest(
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        3, 89890);
+}
+
+/* Compare the attacks from each backend against the ray scan for random
+   occupancies on every square. */
+char* SliderBackendAttacksTest()
+{
+    enum CSC_SliderBackend original = CSC_GetSliderBackend();
+    CSC_Bitboard occ[NUM_OCCUPANCIES];
+    CSC_Bitboard rooks[NUM_OCCUPANCIES], bishops[NUM_OCCUPANCIES];
+    int backend, loc, i, j;
+    bool match = true;
+
+    printf("Slider backend attacks test\n");
+
+    srand(1);
+    for (i = 0; i < NUM_OCCUPANCIES; i++)
+    {
+        occ[i] = 0;
+        for (j = 0; j < 16; j++) occ[i] |= (CSC_Bitboard)1 << (rand() % 64);
+    }
+
+    for (loc = 0; loc < 64; loc++)
+    {
+        CSC_SetSliderBackend(CSC_SLIDER_RAYSCAN);
+        for (i = 0; i < NUM_OCCUPANCIES; i++)
+        {
+            rooks[i] = CSC_RookAttacks(loc, occ[i]);
+            bishops[i] = CSC_BishopAttacks(loc, occ[i]);
+        }
+
+        for (backend = 0; backend < NUM_BACKENDS; backend++)
+        {
+            if (!CSC_SetSliderBackend((enum CSC_SliderBackend)backend)) continue;
+            for (i = 0; i < NUM_OCCUPANCIES; i++)
+            {
+                match &= CSC_RookAttacks(loc, occ[i]) == rooks[i];
+                match &= CSC_BishopAttacks(loc, occ[i]) == bishops[i];
+            }
+        }
+    }
+
+    CSC_SetSliderBackend(original);
+
+    mu_assert("Backends do not agree on slider attacks.", match);
+
+    return NULL;
+}
+
+char* AllSliderTests()
+{
+    printf("Slider backend in use: %s\n", backendNames[CSC_GetSliderBackend()]);
+
+    mu_run_test(SliderBackendAttacksTest);
+    mu_run_test(SliderBackendPerftTest1);
+    mu_run_test(SliderBackendPerftTest2);
+    mu_run_test(SliderBackendPerftTest3);
+    mu_run_test(SliderBackendPerftTest4);
+    mu_run_test(SliderBackendPerftTest5);
+    mu_run_test(SliderBackendPerftTest6);
+    return NULL;
+}
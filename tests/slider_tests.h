@@ -0,0 +1,6 @@
+#ifndef __SLIDER_TESTS_H__
+#define __SLIDER_TESTS_H__
+
+char* AllSliderTests();
+
+#endif /* __SLIDER_TESTS_H__ */
@@ -1,8 +1,12 @@
 #include "chessic.h"
 #include "parser_tests.h"
 #include "movegen_tests.h"
+#include "movepicker_tests.h"
 #include "make_undo_tests.h"
 #include "perft_tests.h"
+#include "position_tests.h"
+#include "see_tests.h"
+#include "slider_tests.h"
 #include "uci_tests.h"
 #include "token_tests.h"
 #include "stdio.h"
@@ -27,8 +31,12 @@ int main()
     pass = RunTests(AllTokenTests)
         && RunTests(AllParserTests)
         && RunTests(AllMoveGenTests)
+        && RunTests(AllMovePickerTests)
         && RunTests(AllMakeUndoTests)
+        && RunTests(AllPositionTests)
         && RunTests(AllUCITests)
+        && RunTests(AllSliderTests)
+        && RunTests(AllSEETests)
         && RunTests(AllPerftTests);
 
     if (pass) printf("ALL TESTS PASSED\n");
@@ -0,0 +1,816 @@
+#include "chessic.h"
+#include "clock.h"
+#include "counters.h"
+#include "ctype.h"
+#include "inttypes.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+#define MAX_LINE_LENGTH 1024
+#define MAX_UCI_COMMAND_LENGTH (CSC_MAX_FEN_LENGTH + 32)
+
+/* The number of quiet moves played from each position before it's used, so
+   that the draw checks have a history to look through. */
+#define HISTORY_PLIES 32
+
+/* The default corpus, which is a mix of the positions in perftsuite.epd
+   (the opening, middlegame, castling, minor piece, pawn and promotion
+   positions). */
+const char* DefaultCorpus[] =
+{
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+    "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1",
+    "1r2k2r/8/8/8/8/8/8/R3K2R w KQk - 0 1",
+    "8/1n4N1/2k5/8/8/5K2/1N4n1/8 w - - 0 1",
+    "8/8/4k3/3Nn3/3nN3/4K3/8/8 w - - 0 1",
+    "B6b/8/8/8/2K5/4k3/8/b6B w - - 0 1",
+    "R6r/8/8/2K5/5k2/8/8/r6R w - - 0 1",
+    "K7/8/8/3Q4/4q3/8/8/7k w - - 0 1",
+    "8/2k1p3/3pP3/3P2K1/8/8/8/8 w - - 0 1",
+    "3k4/3pp3/8/8/8/8/3PP3/3K4 b - - 0 1",
+    "n1n5/1Pk5/8/8/8/8/5Kp1/5N1N w - - 0 1",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1"
+};
+
+/* The command line options. */
+struct Options
+{
+    const char* epd;
+    const char* filter;
+    int warmup;
+    int trials;
+    int repeat;
+    bool csv;
+
+    /* Whether to read the hardware counters around each trial. */
+    bool counters;
+};
+
+/* The positions to run the benchmarks on. */
+struct Corpus
+{
+    int n;
+    char (*fens)[CSC_MAX_FEN_LENGTH];
+
+    /* The positions after the reversible moves which give them a history. */
+    struct CSC_Board** boards;
+
+    /* The same positions after a pair of moves has been played and undone
+       twice more, which makes them a draw by repetition. */
+    struct CSC_Board** repeated;
+
+    /* The legal moves in each position. */
+    struct CSC_MoveList** moves;
+
+    /* A UCI position command for each FEN (which plays the first legal move,
+       so that the moves are parsed too). */
+    char (*commands)[MAX_UCI_COMMAND_LENGTH];
+
+    /* Scratch space for the benchmarks. */
+    struct CSC_MoveList* list;
+
+    /* The hardware counters (if options.counters is set). */
+    struct Counters counters;
+};
+
+/* Run the primitive over every position in the corpus and return the number
+   of operations. */
+typedef uint64_t (*BenchFunc)(struct Corpus*);
+
+struct Benchmark
+{
+    const char* name;
+    BenchFunc func;
+};
+
+/* The order statistics of the nanoseconds per operation of each trial, and
+   the hardware counts over all of the trials. */
+struct BenchResult
+{
+    const char* name;
+    uint64_t opsPerTrial;
+    uint64_t totalOps;
+    double median;
+    double p99;
+    double min;
+    struct CounterValues counters;
+};
+
+/* The results of the primitives are accumulated here so that the calls can't
+   be optimised away. */
+volatile uint64_t Sink;
+
+uint64_t GetMoves(struct Corpus* corpus, enum CSC_MoveGenType type)
+{
+    int i;
+
+    for (i = 0; i < corpus->n; i++)
+    {
+        corpus->list->n = 0;
+        CSC_GetMoves(corpus->boards[i], corpus->list, type);
+        Sink += corpus->list->n;
+    }
+
+    return corpus->n;
+}
+
+uint64_t BenchGetMovesAll(struct Corpus* corpus)
+{
+    return GetMoves(corpus, CSC_ALL);
+}
+
+uint64_t BenchGetMovesQuiets(struct Corpus* corpus)
+{
+    return GetMoves(corpus, CSC_QUIETS);
+}
+
+uint64_t BenchGetMovesCaptures(struct Corpus* corpus)
+{
+    return GetMoves(corpus, CSC_CAPTURES);
+}
+
+/* Each operation is a move being made and undone. */
+uint64_t BenchMakeUndo(struct Corpus* corpus)
+{
+    struct CSC_MoveList* l;
+    uint64_t ops = 0;
+    int i, j;
+
+    for (i = 0; i < corpus->n; i++)
+    {
+        l = corpus->moves[i];
+        for (j = 0; j < l->n; j++)
+        {
+            CSC_MakeMove(corpus->boards[i], l->moves[j]);
+            CSC_UndoMove(corpus->boards[i]);
+        }
+
+        ops += l->n;
+    }
+
+    return ops;
+}
+
+/* Each operation checks one square. */
+uint64_t BenchIsAttacked(struct Corpus* corpus)
+{
+    int i, loc;
+
+    for (i = 0; i < corpus->n; i++)
+    {
+        for (loc = 0; loc < CSC_SQUARE_NB; loc++)
+        {
+            Sink += CSC_IsAttacked(corpus->boards[i], loc);
+        }
+    }
+
+    return (uint64_t)corpus->n*CSC_SQUARE_NB;
+}
+
+uint64_t BenchIsLegal(struct Corpus* corpus)
+{
+    struct CSC_MoveList* l;
+    uint64_t ops = 0;
+    int i, j;
+
+    for (i = 0; i < corpus->n; i++)
+    {
+        l = corpus->moves[i];
+        for (j = 0; j < l->n; j++)
+        {
+            Sink += CSC_IsLegal(corpus->boards[i], l->moves[j]);
+        }
+
+        ops += l->n;
+    }
+
+    return ops;
+}
+
+uint64_t IsDrawn(struct Corpus* corpus, struct CSC_Board** boards)
+{
+    int i;
+
+    for (i = 0; i < corpus->n; i++)
+    {
+        Sink += CSC_IsDrawn(boards[i]);
+    }
+
+    return corpus->n;
+}
+
+/* None of the positions in the history repeat, so this is the common case in
+   a search. */
+uint64_t BenchIsDrawn(struct Corpus* corpus)
+{
+    return IsDrawn(corpus, corpus->boards);
+}
+
+/* This has to look back through the history to find the repetitions. */
+uint64_t BenchIsDrawnRepetition(struct Corpus* corpus)
+{
+    return IsDrawn(corpus, corpus->repeated);
+}
+
+/* Each operation includes freeing the board. */
+uint64_t BenchBoardFromFEN(struct Corpus* corpus)
+{
+    struct CSC_Board* b;
+    int i;
+
+    for (i = 0; i < corpus->n; i++)
+    {
+        b = CSC_BoardFromFEN(corpus->fens[i]);
+        Sink += CSC_GetHash(b);
+        CSC_FreeBoard(b);
+    }
+
+    return corpus->n;
+}
+
+uint64_t BenchFENFromBoard(struct Corpus* corpus)
+{
+    char fen[CSC_MAX_FEN_LENGTH];
+    int i, len;
+
+    for (i = 0; i < corpus->n; i++)
+    {
+        CSC_FENFromBoard(corpus->boards[i], fen, &len);
+        Sink += len;
+    }
+
+    return corpus->n;
+}
+
+void OnPosition(struct CSC_Board* b)
+{
+    Sink += CSC_GetHash(b);
+    CSC_FreeBoard(b);
+}
+
+/* Each operation is a position command (including the engine freeing the
+   board which it receives). */
+uint64_t BenchUCIProcess(struct Corpus* corpus)
+{
+    struct CSC_UCICallbacks callbacks;
+    int i;
+
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.onPosition = OnPosition;
+
+    for (i = 0; i < corpus->n; i++)
+    {
+        CSC_UCIProcess(corpus->commands[i], &callbacks);
+    }
+
+    return corpus->n;
+}
+
+const struct Benchmark Benchmarks[] =
+{
+    { "get_moves_all", BenchGetMovesAll },
+    { "get_moves_quiets", BenchGetMovesQuiets },
+    { "get_moves_captures", BenchGetMovesCaptures },
+    { "make_undo_move", BenchMakeUndo },
+    { "is_attacked", BenchIsAttacked },
+    { "is_legal", BenchIsLegal },
+    { "is_drawn", BenchIsDrawn },
+    { "is_drawn_repetition", BenchIsDrawnRepetition },
+    { "board_from_fen", BenchBoardFromFEN },
+    { "fen_from_board", BenchFENFromBoard },
+    { "uci_process", BenchUCIProcess }
+};
+
+#define NUM_BENCHMARKS (int)(sizeof(Benchmarks)/sizeof(struct Benchmark))
+
+void PrintUsage()
+{
+    fprintf(stderr,
+        "Usage: chessic_bench [--epd FILE] [--filter NAME] [--warmup N]"
+        " [--trials N] [--repeat N] [--csv] [--no-counters]\n");
+    fprintf(stderr,
+        "  --epd FILE     Use the positions in the EPD file rather than the\n"
+        "                 built in corpus.\n"
+        "  --filter NAME  Only run the benchmarks whose names contain this.\n"
+        "  --warmup N     The number of untimed trials (default 10).\n");
+    fprintf(stderr,
+        "  --trials N     The number of timed trials (default 100).\n"
+        "  --repeat N     The number of passes over the corpus in each trial\n"
+        "                 (default 10).\n"
+        "  --csv          Write the results as CSV rather than JSON.\n"
+        "  --no-counters  Don't read the hardware performance counters.\n");
+}
+
+bool ParseOptions(int argc, char** argv, struct Options* options)
+{
+    int i;
+
+    options->epd = NULL;
+    options->filter = NULL;
+    options->warmup = 10;
+    options->trials = 100;
+    options->repeat = 10;
+    options->csv = false;
+    options->counters = true;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--csv") == 0)
+        {
+            options->csv = true;
+        }
+        else if (strcmp(argv[i], "--no-counters") == 0)
+        {
+            options->counters = false;
+        }
+        else if (i + 1 == argc)
+        {
+            return false;
+        }
+        else if (strcmp(argv[i], "--epd") == 0)
+        {
+            options->epd = argv[++i];
+        }
+        else if (strcmp(argv[i], "--filter") == 0)
+        {
+            options->filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--warmup") == 0)
+        {
+            options->warmup = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--trials") == 0)
+        {
+            options->trials = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--repeat") == 0)
+        {
+            options->repeat = atoi(argv[++i]);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return options->warmup >= 0 && options->trials > 0 && options->repeat > 0;
+}
+
+/* Check whether the move keeps the 50 move counter going i.e. it's a quiet
+   move by a piece other than a pawn. Checks are left out so that the other
+   player doesn't run out of quiet moves. */
+bool IsQuietShuffle(struct CSC_Board* b, CSC_Move m)
+{
+    enum CSC_PieceType pt = CSC_GetPieceType(b->squares[CSC_GetMoveStart(m)]);
+
+    return pt != CSC_PAWN
+        && CSC_GetMoveType(m) == CSC_NORMAL
+        && !CSC_GivesCheck(b, m);
+}
+
+/* Check whether the move can be played back again, which also needs it not to
+   give up any castling rights. */
+bool IsReversible(struct CSC_Board* b, CSC_Move m)
+{
+    struct CSC_CastlingRights rights = CSC_GetCastlingRights(b, b->player);
+    enum CSC_PieceType pt = CSC_GetPieceType(b->squares[CSC_GetMoveStart(m)]);
+
+    if (!IsQuietShuffle(b, m)) return false;
+    if (pt == CSC_KING || pt == CSC_ROOK)
+        return !rights.kingSide && !rights.queenSide;
+
+    return true;
+}
+
+/* Get the move which goes back the way that the move came, if it's legal. */
+CSC_Move ReverseMove(struct CSC_Board* b, CSC_Move m)
+{
+    CSC_Move r = CSC_CreateMove(
+        CSC_GetMoveEnd(m),
+        CSC_GetMoveStart(m),
+        CSC_NONE,
+        CSC_NORMAL);
+
+    return CSC_IsPseudoLegal(b, r) && CSC_IsLegal(b, r) ? r : CSC_NO_MOVE;
+}
+
+/* Play quiet moves by pieces other than pawns, taking the first one each time
+   which doesn't repeat an earlier position, so that the history is always the
+   same. This stops early if there are no such moves. */
+void PlayHistory(struct CSC_Board* b, struct CSC_MoveList* l)
+{
+    CSC_Hash seen[HISTORY_PLIES + 1];
+    bool found = true;
+    int n = 0, i, j;
+
+    seen[n++] = CSC_GetHash(b);
+
+    while (found && n <= HISTORY_PLIES)
+    {
+        l->n = 0;
+        CSC_GetMoves(b, l, CSC_QUIETS);
+
+        found = false;
+        for (i = 0; i < l->n && !found; i++)
+        {
+            if (!IsQuietShuffle(b, l->moves[i])) continue;
+
+            CSC_MakeMove(b, l->moves[i]);
+
+            found = true;
+            for (j = 0; j < n; j++) found = found && seen[j] != CSC_GetHash(b);
+
+            if (found) seen[n++] = CSC_GetHash(b);
+            else CSC_UndoMove(b);
+        }
+    }
+}
+
+/* Play a reversible move for each player and then move both pieces back, which
+   repeats the position. Returns false if there's no such pair of moves. */
+bool PlayShuffle(
+    struct CSC_Board* b,
+    struct CSC_MoveList* first,
+    struct CSC_MoveList* second)
+{
+    CSC_Move r1, r2;
+    int i, j;
+
+    first->n = 0;
+    CSC_GetMoves(b, first, CSC_QUIETS);
+
+    for (i = 0; i < first->n; i++)
+    {
+        if (!IsReversible(b, first->moves[i])) continue;
+
+        CSC_MakeMove(b, first->moves[i]);
+
+        second->n = 0;
+        CSC_GetMoves(b, second, CSC_QUIETS);
+
+        for (j = 0; j < second->n; j++)
+        {
+            if (!IsReversible(b, second->moves[j])) continue;
+
+            CSC_MakeMove(b, second->moves[j]);
+
+            r1 = ReverseMove(b, first->moves[i]);
+            if (r1 != CSC_NO_MOVE)
+            {
+                CSC_MakeMove(b, r1);
+
+                r2 = ReverseMove(b, second->moves[j]);
+                if (r2 != CSC_NO_MOVE)
+                {
+                    CSC_MakeMove(b, r2);
+                    return true;
+                }
+
+                CSC_UndoMove(b);
+            }
+
+            CSC_UndoMove(b);
+        }
+
+        CSC_UndoMove(b);
+    }
+
+    return false;
+}
+
+bool AddPosition(struct Corpus* corpus, const char* fen)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(fen);
+    struct CSC_Board* repeated;
+    struct CSC_MoveList* l;
+    char move[CSC_MAX_UCI_MOVE_LENGTH];
+    size_t n = strlen(fen);
+    int i;
+
+    if (b == NULL)
+    {
+        fprintf(stderr, "Invalid FEN: %s\n", fen);
+        return false;
+    }
+
+    if (n >= CSC_MAX_FEN_LENGTH) n = CSC_MAX_FEN_LENGTH - 1;
+
+    i = corpus->n++;
+    corpus->fens = realloc(corpus->fens, corpus->n*sizeof(*corpus->fens));
+    corpus->boards = realloc(corpus->boards, corpus->n*sizeof(*corpus->boards));
+    corpus->repeated = realloc(
+        corpus->repeated,
+        corpus->n*sizeof(*corpus->repeated));
+    corpus->moves = realloc(corpus->moves, corpus->n*sizeof(*corpus->moves));
+    corpus->commands = realloc(
+        corpus->commands,
+        corpus->n*sizeof(*corpus->commands));
+
+    memset(corpus->fens[i], 0, CSC_MAX_FEN_LENGTH);
+    memcpy(corpus->fens[i], fen, n);
+
+    /* The UCI command is for the position in the FEN. */
+    l = CSC_MakeMoveList();
+    CSC_GetMoves(b, l, CSC_ALL);
+
+    strcpy(corpus->commands[i], "position fen ");
+    strcat(corpus->commands[i], corpus->fens[i]);
+
+    if (l->n > 0)
+    {
+        memset(move, 0, sizeof(move));
+        CSC_MoveToUCIString(l->moves[0], move, NULL);
+        strcat(corpus->commands[i], " moves ");
+        strcat(corpus->commands[i], move);
+    }
+
+    PlayHistory(b, l);
+
+    repeated = CSC_CopyBoard(b);
+    if (PlayShuffle(repeated, l, corpus->list))
+        PlayShuffle(repeated, l, corpus->list);
+
+    l->n = 0;
+    CSC_GetMoves(b, l, CSC_ALL);
+
+    corpus->boards[i] = b;
+    corpus->repeated[i] = repeated;
+    corpus->moves[i] = l;
+
+    return true;
+}
+
+/* Take the FEN from each line of the file e.g. "<FEN> ;D1 20 ;D2 400". */
+bool LoadEPD(const char* path, struct Corpus* corpus)
+{
+    char line[MAX_LINE_LENGTH];
+    char* end;
+    size_t n;
+    FILE* f = fopen(path, "r");
+
+    if (f == NULL)
+    {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    while (fgets(line, MAX_LINE_LENGTH, f))
+    {
+        end = strchr(line, ';');
+        if (end != NULL) *end = '\0';
+
+        n = strlen(line);
+        while (n > 0 && isspace(line[n - 1])) line[--n] = '\0';
+        if (n == 0) continue;
+
+        if (!AddPosition(corpus, line))
+        {
+            fclose(f);
+            return false;
+        }
+    }
+
+    fclose(f);
+
+    return corpus->n > 0;
+}
+
+void FreeCorpus(struct Corpus* corpus)
+{
+    int i;
+
+    for (i = 0; i < corpus->n; i++)
+    {
+        CSC_FreeBoard(corpus->boards[i]);
+        CSC_FreeBoard(corpus->repeated[i]);
+        CSC_FreeMoveList(corpus->moves[i]);
+    }
+
+    free(corpus->fens);
+    free(corpus->boards);
+    free(corpus->repeated);
+    free(corpus->moves);
+    free(corpus->commands);
+    CSC_FreeMoveList(corpus->list);
+}
+
+int CompareDoubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Run the benchmark and take the order statistics of the time per operation
+   over the trials. */
+void RunBenchmark(
+    const struct Benchmark* bench,
+    struct Corpus* corpus,
+    const struct Options* options,
+    struct BenchResult* result)
+{
+    double* times = malloc(options->trials*sizeof(double));
+    uint64_t ops, start, timeNs;
+    struct CounterValues values;
+    int t, r, p99, c;
+
+    result->totalOps = 0;
+    ClearCounterValues(&result->counters);
+
+    /* None of the counts are valid if the counters aren't being read. */
+    if (!options->counters)
+    {
+        for (c = 0; c < COUNTER_NB; c++) result->counters.valid[c] = false;
+    }
+
+    for (t = 0; t < options->warmup; t++)
+    {
+        for (r = 0; r < options->repeat; r++) bench->func(corpus);
+    }
+
+    for (t = 0; t < options->trials; t++)
+    {
+        ops = 0;
+
+        /* The counters are started outside of the timed region because the
+           system calls are slow compared with the primitives. */
+        if (options->counters) StartCounters(&corpus->counters);
+
+        start = ClockNs();
+        for (r = 0; r < options->repeat; r++) ops += bench->func(corpus);
+        timeNs = ClockNs() - start;
+
+        if (options->counters)
+        {
+            StopCounters(&corpus->counters, &values);
+            AddCounterValues(&result->counters, &values);
+        }
+
+        times[t] = ops > 0 ? (double)timeNs/ops : 0.0;
+        result->opsPerTrial = ops;
+        result->totalOps += ops;
+    }
+
+    qsort(times, options->trials, sizeof(double), CompareDoubles);
+
+    /* This is the nearest rank percentile. */
+    p99 = (99*options->trials + 99)/100 - 1;
+
+    result->name = bench->name;
+    result->median = options->trials % 2 == 1
+        ? times[options->trials/2]
+        : (times[options->trials/2 - 1] + times[options->trials/2])/2;
+    result->p99 = times[p99];
+    result->min = times[0];
+
+    free(times);
+}
+
+/* Get the average count per operation, or a negative number if the counter
+   wasn't read. */
+double CountPerOp(const struct BenchResult* result, int counter)
+{
+    if (!result->counters.valid[counter] || result->totalOps == 0) return -1;
+    return (double)result->counters.counts[counter]/result->totalOps;
+}
+
+void PrintJSON(
+    const struct BenchResult* results,
+    int n,
+    const struct Corpus* corpus,
+    const struct Options* options)
+{
+    double perOp;
+    int i, c;
+
+    printf("{\n");
+    printf("  \"positions\": %d,\n", corpus->n);
+    printf("  \"warmup\": %d,\n", options->warmup);
+    printf("  \"trials\": %d,\n", options->trials);
+    printf("  \"repeat\": %d,\n", options->repeat);
+    printf("  \"counters\": %s,\n", options->counters ? "true" : "false");
+    printf("  \"results\": [");
+
+    for (i = 0; i < n; i++)
+    {
+        printf("%s\n    {\n", i > 0 ? "," : "");
+        printf("      \"name\": \"%s\",\n", results[i].name);
+        printf("      \"ops_per_trial\": %" PRIu64 ",\n", results[i].opsPerTrial);
+        printf("      \"median_ns\": %.2f,\n", results[i].median);
+        printf("      \"p99_ns\": %.2f,\n", results[i].p99);
+        printf("      \"min_ns\": %.2f", results[i].min);
+
+        for (c = 0; c < COUNTER_NB; c++)
+        {
+            perOp = CountPerOp(&results[i], c);
+            if (perOp >= 0)
+            {
+                printf(",\n      \"%s_per_op\": %.2f", CounterNames[c], perOp);
+            }
+        }
+
+        printf("\n    }");
+    }
+
+    printf("\n  ]\n}\n");
+}
+
+/* The counter columns are always present, but are empty if the counters
+   weren't read. */
+void PrintCSV(const struct BenchResult* results, int n)
+{
+    double perOp;
+    int i, c;
+
+    printf("name,ops_per_trial,median_ns,p99_ns,min_ns");
+    for (c = 0; c < COUNTER_NB; c++) printf(",%s_per_op", CounterNames[c]);
+    printf("\n");
+
+    for (i = 0; i < n; i++)
+    {
+        printf("%s,%" PRIu64 ",%.2f,%.2f,%.2f",
+            results[i].name,
+            results[i].opsPerTrial,
+            results[i].median,
+            results[i].p99,
+            results[i].min);
+
+        for (c = 0; c < COUNTER_NB; c++)
+        {
+            perOp = CountPerOp(&results[i], c);
+            if (perOp >= 0) printf(",%.2f", perOp);
+            else printf(",");
+        }
+
+        printf("\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    struct Options options;
+    struct Corpus corpus;
+    struct BenchResult results[NUM_BENCHMARKS];
+    int i, n = 0;
+
+    if (!ParseOptions(argc, argv, &options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    CSC_InitBits();
+    CSC_InitZobrist();
+
+    memset(&corpus, 0, sizeof(corpus));
+    corpus.list = CSC_MakeMoveList();
+
+    if (options.epd != NULL)
+    {
+        if (!LoadEPD(options.epd, &corpus))
+        {
+            FreeCorpus(&corpus);
+            return 1;
+        }
+    }
+    else
+    {
+        for (i = 0; i < (int)(sizeof(DefaultCorpus)/sizeof(char*)); i++)
+        {
+            AddPosition(&corpus, DefaultCorpus[i]);
+        }
+    }
+
+    if (options.counters && !OpenCounters(&corpus.counters))
+    {
+        fprintf(stderr, "The hardware counters are unavailable.\n");
+        CloseCounters(&corpus.counters);
+        options.counters = false;
+    }
+
+    for (i = 0; i < NUM_BENCHMARKS; i++)
+    {
+        if (options.filter != NULL
+            && strstr(Benchmarks[i].name, options.filter) == NULL)
+        {
+            continue;
+        }
+
+        fprintf(stderr, "%s\n", Benchmarks[i].name);
+        RunBenchmark(&Benchmarks[i], &corpus, &options, &results[n++]);
+    }
+
+    if (options.csv)
+        PrintCSV(results, n);
+    else
+        PrintJSON(results, n, &corpus, &options);
+
+    if (options.counters) CloseCounters(&corpus.counters);
+    FreeCorpus(&corpus);
+
+    return 0;
+}
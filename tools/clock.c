@@ -0,0 +1,12 @@
+/* clock_gettime is POSIX rather than ANSI C. */
+#define _POSIX_C_SOURCE 199309L
+
+#include "clock.h"
+#include "time.h"
+
+uint64_t ClockNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
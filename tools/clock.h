@@ -0,0 +1,10 @@
+#ifndef __CHESSIC_TOOLS_CLOCK_H__
+#define __CHESSIC_TOOLS_CLOCK_H__
+
+#include "stdint.h"
+
+/* Get the time in nanoseconds from a monotonic clock (only the difference
+   between two times is meaningful). */
+uint64_t ClockNs();
+
+#endif /* __CHESSIC_TOOLS_CLOCK_H__ */
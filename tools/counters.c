@@ -0,0 +1,190 @@
+/* syscall is only declared for GNU (perf_event_open has no libc wrapper). */
+#define _GNU_SOURCE
+
+#include "counters.h"
+#include "string.h"
+
+const char* CounterNames[COUNTER_NB] =
+{
+    "cycles",
+    "instructions",
+    "branch_misses",
+    "l1d_misses",
+    "llc_misses"
+};
+
+#ifdef __linux__
+
+#include "linux/perf_event.h"
+#include "sys/ioctl.h"
+#include "sys/syscall.h"
+#include "unistd.h"
+
+/* The cache events are encoded as the cache, the operation and the result. */
+#define CACHE_READ_MISS(cache) ((cache) \
+    | (PERF_COUNT_HW_CACHE_OP_READ << 8) \
+    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/* The value read from each counter (given the read format below). */
+struct CounterRead
+{
+    uint64_t value;
+    uint64_t timeEnabled;
+    uint64_t timeRunning;
+};
+
+int OpenCounter(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+        | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+bool OpenCounters(struct Counters* c)
+{
+    bool any = false;
+    int i;
+
+    c->fds[COUNTER_CYCLES] = OpenCounter(
+        PERF_TYPE_HARDWARE,
+        PERF_COUNT_HW_CPU_CYCLES);
+
+    c->fds[COUNTER_INSTRUCTIONS] = OpenCounter(
+        PERF_TYPE_HARDWARE,
+        PERF_COUNT_HW_INSTRUCTIONS);
+
+    c->fds[COUNTER_BRANCH_MISSES] = OpenCounter(
+        PERF_TYPE_HARDWARE,
+        PERF_COUNT_HW_BRANCH_MISSES);
+
+    c->fds[COUNTER_L1D_MISSES] = OpenCounter(
+        PERF_TYPE_HW_CACHE,
+        CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D));
+
+    c->fds[COUNTER_LLC_MISSES] = OpenCounter(
+        PERF_TYPE_HW_CACHE,
+        CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL));
+
+    for (i = 0; i < COUNTER_NB; i++) any = any || c->fds[i] >= 0;
+
+    return any;
+}
+
+void CloseCounters(struct Counters* c)
+{
+    int i;
+
+    for (i = 0; i < COUNTER_NB; i++)
+    {
+        if (c->fds[i] >= 0) close(c->fds[i]);
+        c->fds[i] = -1;
+    }
+}
+
+void StartCounters(struct Counters* c)
+{
+    int i;
+
+    for (i = 0; i < COUNTER_NB; i++)
+    {
+        if (c->fds[i] < 0) continue;
+        ioctl(c->fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(c->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void StopCounters(struct Counters* c, struct CounterValues* values)
+{
+    struct CounterRead r;
+    int i;
+
+    for (i = 0; i < COUNTER_NB; i++)
+    {
+        if (c->fds[i] >= 0) ioctl(c->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (i = 0; i < COUNTER_NB; i++)
+    {
+        values->counts[i] = 0;
+        values->valid[i] = c->fds[i] >= 0
+            && read(c->fds[i], &r, sizeof(r)) == (ssize_t)sizeof(r)
+            && r.timeRunning > 0;
+
+        if (!values->valid[i]) continue;
+
+        /* Scale up the count if the event was only counted for part of the
+           time because there were more events than hardware counters. */
+        values->counts[i] = r.timeRunning < r.timeEnabled
+            ? (uint64_t)((double)r.value*r.timeEnabled/r.timeRunning)
+            : r.value;
+    }
+}
+
+#else
+
+bool OpenCounters(struct Counters* c)
+{
+    int i;
+    for (i = 0; i < COUNTER_NB; i++) c->fds[i] = -1;
+    return false;
+}
+
+void CloseCounters(struct Counters* c)
+{
+    (void)c;
+}
+
+void StartCounters(struct Counters* c)
+{
+    (void)c;
+}
+
+void StopCounters(struct Counters* c, struct CounterValues* values)
+{
+    int i;
+
+    (void)c;
+
+    for (i = 0; i < COUNTER_NB; i++)
+    {
+        values->counts[i] = 0;
+        values->valid[i] = false;
+    }
+}
+
+#endif /* __linux__ */
+
+void AddCounterValues(
+    struct CounterValues* total,
+    const struct CounterValues* values)
+{
+    int i;
+
+    for (i = 0; i < COUNTER_NB; i++)
+    {
+        total->counts[i] += values->counts[i];
+        total->valid[i] = total->valid[i] && values->valid[i];
+    }
+}
+
+void ClearCounterValues(struct CounterValues* values)
+{
+    int i;
+
+    for (i = 0; i < COUNTER_NB; i++)
+    {
+        values->counts[i] = 0;
+        values->valid[i] = true;
+    }
+}
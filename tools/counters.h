@@ -0,0 +1,52 @@
+#ifndef __CHESSIC_TOOLS_COUNTERS_H__
+#define __CHESSIC_TOOLS_COUNTERS_H__
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/* The hardware events which are counted (using perf_event_open on Linux). */
+enum CounterType
+{
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_L1D_MISSES,
+    COUNTER_LLC_MISSES,
+    COUNTER_NB
+};
+
+/* The names of the counters in the JSON and CSV output. */
+extern const char* CounterNames[COUNTER_NB];
+
+/* The open counters for the calling thread (and any threads that it creates
+   while they are open). A file descriptor is negative if the event couldn't
+   be opened, e.g. because the kernel doesn't permit it. */
+struct Counters
+{
+    int fds[COUNTER_NB];
+};
+
+/* The counts over a measured region. Only the valid ones should be reported.
+   The counts are scaled up if the kernel had to multiplex the events. */
+struct CounterValues
+{
+    uint64_t counts[COUNTER_NB];
+    bool valid[COUNTER_NB];
+};
+
+/* Open the counters, returning false if none of them are available. */
+bool OpenCounters(struct Counters*);
+void CloseCounters(struct Counters*);
+
+/* Reset the counters and start counting. */
+void StartCounters(struct Counters*);
+
+/* Stop counting and read the counts since the counters were started. */
+void StopCounters(struct Counters*, struct CounterValues*);
+
+/* Add the counts to a running total (a count is only valid if it is valid in
+   both). */
+void AddCounterValues(struct CounterValues* total, const struct CounterValues*);
+void ClearCounterValues(struct CounterValues*);
+
+#endif /* __CHESSIC_TOOLS_COUNTERS_H__ */
@@ -0,0 +1,241 @@
+#include "perft.h"
+#include "threads.h"
+#include "stdlib.h"
+
+/* The subtree after making up to two moves from the root. */
+struct PerftTask
+{
+    int rootIndex;
+    int numMoves;
+    CSC_Move moves[2];
+    int depth;
+    uint64_t nodes;
+    struct PerftStats stats;
+};
+
+/* The work shared between the threads. */
+struct PerftWork
+{
+    struct CSC_Board* b;
+    struct PerftTable* table;
+    struct PerftTask* tasks;
+    struct TaskQueue queue;
+};
+
+struct PerftTable* CreatePerftTable(size_t megabytes)
+{
+    struct PerftTable* table = malloc(sizeof(struct PerftTable));
+    size_t size = 1;
+
+    while (2*size*sizeof(struct PerftEntry) <= megabytes << 20) size *= 2;
+
+    table->entries = calloc(size, sizeof(struct PerftEntry));
+    table->mask = size - 1;
+
+    if (table->entries == NULL)
+    {
+        free(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+void FreePerftTable(struct PerftTable* table)
+{
+    if (table != NULL)
+    {
+        free(table->entries);
+        free(table);
+    }
+}
+
+struct PerftState* CreatePerftState(struct CSC_Board* b)
+{
+    struct PerftState* ps = malloc(sizeof(struct PerftState));
+    int i;
+
+    ps->b = b;
+    ps->table = NULL;
+    ps->stats.probes = 0;
+    ps->stats.hits = 0;
+
+    for (i = 0; i < MAX_PERFT_DEPTH; i++)
+    {
+        ps->lists[i] = CSC_MakeMoveList();
+    }
+
+    CSC_ReserveHistory(b, MAX_PERFT_DEPTH);
+
+    return ps;
+}
+
+void FreePerftState(struct PerftState* ps)
+{
+    int i;
+
+    if (ps != NULL)
+    {
+        for (i = 0; i < MAX_PERFT_DEPTH; i++)
+        {
+            CSC_FreeMoveList(ps->lists[i]);
+        }
+
+        CSC_FreeBoard(ps->b);
+        free(ps);
+    }
+}
+
+uint64_t Perft(struct PerftState* ps, int depth)
+{
+    struct CSC_MoveList* l;
+    struct PerftEntry* entry = NULL;
+    CSC_Hash hash = 0;
+    uint64_t nodes = 0, data;
+    int i;
+
+    if (depth == 0) return 1;
+
+    /* At the last ply we only need the number of moves. */
+    if (depth == 1) return CSC_CountMovesNoDrawCheck(ps->b, CSC_ALL);
+
+    if (ps->table != NULL)
+    {
+        hash = CSC_GetHash(ps->b);
+        entry = &ps->table->entries[hash & ps->table->mask];
+
+        ++ps->stats.probes;
+
+        data = entry->data;
+        if ((entry->check ^ data) == hash && (int)(data & 0xFF) == depth)
+        {
+            ++ps->stats.hits;
+            return data >> 8;
+        }
+    }
+
+    l = ps->lists[depth - 1];
+    l->n = 0;
+
+    CSC_GetMovesNoDrawCheck(ps->b, l, CSC_ALL);
+    for (i = 0; i < l->n; i++)
+    {
+        CSC_MakeMove(ps->b, l->moves[i]);
+        nodes += Perft(ps, depth - 1);
+        CSC_UndoMove(ps->b);
+    }
+
+    if (entry != NULL)
+    {
+        data = (nodes << 8) | depth;
+        entry->data = data;
+        entry->check = hash ^ data;
+    }
+
+    return nodes;
+}
+
+void* PerftWorker(void* arg)
+{
+    struct PerftWork* work = arg;
+    struct PerftState* ps = CreatePerftState(CSC_CopyBoard(work->b));
+    struct PerftTask* task;
+    struct PerftStats before;
+    int t, i;
+
+    ps->table = work->table;
+
+    while ((t = TakeTask(&work->queue)) >= 0)
+    {
+        task = &work->tasks[t];
+        before = ps->stats;
+
+        for (i = 0; i < task->numMoves; i++) CSC_MakeMove(ps->b, task->moves[i]);
+        task->nodes = Perft(ps, task->depth);
+        for (i = 0; i < task->numMoves; i++) CSC_UndoMove(ps->b);
+
+        task->stats.probes = ps->stats.probes - before.probes;
+        task->stats.hits = ps->stats.hits - before.hits;
+    }
+
+    FreePerftState(ps);
+
+    return NULL;
+}
+
+uint64_t ParallelPerft(
+    struct CSC_Board* b,
+    int depth,
+    int threads,
+    struct PerftTable* table,
+    struct CSC_MoveList* root,
+    uint64_t* divide,
+    struct PerftStats* stats)
+{
+    struct CSC_MoveList* l = CSC_MakeMoveList();
+    struct PerftWork work;
+    struct PerftTask* task;
+    uint64_t nodes = 0;
+    int numTasks = 0, capacity = CSC_MAX_MOVES, i, j;
+
+    root->n = 0;
+    CSC_GetMovesNoDrawCheck(b, root, CSC_ALL);
+
+    work.b = b;
+    work.table = table;
+    work.tasks = malloc(capacity*sizeof(struct PerftTask));
+
+    for (i = 0; i < root->n; i++)
+    {
+        divide[i] = depth == 1 ? 1 : 0;
+        if (depth == 1) continue;
+
+        /* Split the deeper trees after the second move for better balance. */
+        l->n = 0;
+        if (depth >= 3)
+        {
+            CSC_MakeMove(b, root->moves[i]);
+            CSC_GetMovesNoDrawCheck(b, l, CSC_ALL);
+            CSC_UndoMove(b);
+        }
+
+        for (j = 0; j < (depth >= 3 ? l->n : 1); j++)
+        {
+            if (numTasks == capacity)
+            {
+                capacity *= 2;
+                work.tasks = realloc(
+                    work.tasks,
+                    capacity*sizeof(struct PerftTask));
+            }
+
+            task = &work.tasks[numTasks++];
+            task->rootIndex = i;
+            task->numMoves = depth >= 3 ? 2 : 1;
+            task->moves[0] = root->moves[i];
+            task->moves[1] = depth >= 3 ? l->moves[j] : CSC_NO_MOVE;
+            task->depth = depth - task->numMoves;
+            task->nodes = 0;
+            task->stats.probes = 0;
+            task->stats.hits = 0;
+        }
+    }
+
+    InitTaskQueue(&work.queue, numTasks);
+    RunThreads(threads, PerftWorker, &work);
+    FreeTaskQueue(&work.queue);
+
+    for (i = 0; i < numTasks; i++)
+    {
+        divide[work.tasks[i].rootIndex] += work.tasks[i].nodes;
+        stats->probes += work.tasks[i].stats.probes;
+        stats->hits += work.tasks[i].stats.hits;
+    }
+
+    for (i = 0; i < root->n; i++) nodes += divide[i];
+
+    free(work.tasks);
+    CSC_FreeMoveList(l);
+
+    return nodes;
+}
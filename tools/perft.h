@@ -0,0 +1,76 @@
+#ifndef __CHESSIC_TOOLS_PERFT_H__
+#define __CHESSIC_TOOLS_PERFT_H__
+
+#include "chessic.h"
+
+/* The maximum depth that perft can be run to. */
+#define MAX_PERFT_DEPTH 16
+
+/* An entry in the perft hash table. The data is the node count shifted left by
+   8 bits plus the depth, and the check is the data XORed with the position's
+   hash. The entries are read and written without locking, so an entry that is
+   being written by another thread just fails the check. */
+struct PerftEntry
+{
+    uint64_t check;
+    uint64_t data;
+};
+
+/* A hash table of node counts which can be shared between threads. */
+struct PerftTable
+{
+    struct PerftEntry* entries;
+    uint64_t mask;
+};
+
+/* Create a table using up to the size in megabytes (rounded down to a power
+   of 2 number of entries). Returns NULL if the memory can't be allocated. */
+struct PerftTable* CreatePerftTable(size_t megabytes);
+
+void FreePerftTable(struct PerftTable*);
+
+struct PerftStats
+{
+    uint64_t probes;
+    uint64_t hits;
+};
+
+/* Everything needed to run perft on one board. */
+struct PerftState
+{
+    struct CSC_Board* b;
+
+    /* A move list for each ply. */
+    struct CSC_MoveList* lists[MAX_PERFT_DEPTH];
+
+    /* The hash table to use (or NULL) and how well it's doing. */
+    struct PerftTable* table;
+    struct PerftStats stats;
+};
+
+/* The state takes ownership of the board. It doesn't use a hash table unless
+   one is set. */
+struct PerftState* CreatePerftState(struct CSC_Board*);
+
+void FreePerftState(struct PerftState*);
+
+/* Count the leaf nodes of the legal move tree to the given depth. */
+uint64_t Perft(struct PerftState*, int depth);
+
+/* Count the leaf nodes using the number of threads. The subtrees after each
+   root move (or each pair of moves from the root if the depth is at least 3)
+   are shared out between the threads, which each have their own copy of the
+   board. The root moves are generated into the list and the number of nodes
+   after each of them is written to the divide array (which must have space
+   for CSC_MAX_MOVES counts). The threads share the hash table (if there is
+   one) and their hash table statistics are added to the stats. */
+uint64_t ParallelPerft(
+    struct CSC_Board*,
+    int depth,
+    int threads,
+    struct PerftTable*,
+    struct CSC_MoveList* root,
+    uint64_t* divide,
+    struct PerftStats*);
+
+#endif /* __CHESSIC_TOOLS_PERFT_H__ */
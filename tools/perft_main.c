@@ -0,0 +1,534 @@
+#include "chessic.h"
+#include "clock.h"
+#include "counters.h"
+#include "perft.h"
+#include "threads.h"
+#include "ctype.h"
+#include "inttypes.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+#define MAX_LINE_LENGTH 1024
+
+/* The command line options. */
+struct Options
+{
+    const char* fen;
+    const char* epd;
+    int depth;
+    int minDepth;
+    int maxDepth;
+    bool divide;
+    int threads;
+
+    /* The size of the hash table in megabytes (no table if this is zero). */
+    int hashMB;
+
+    /* Whether the threads split the positions between them (rather than
+       splitting the moves of each position). */
+    bool splitPositions;
+
+    /* Whether to read the hardware counters while running each position. */
+    bool counters;
+};
+
+/* A position to run perft on and the results. */
+struct Job
+{
+    char fen[CSC_MAX_FEN_LENGTH];
+    int depth;
+
+    /* The expected count is only checked if there is one (e.g. from an EPD
+       file). It can legitimately be zero, e.g. for a mated root position. */
+    bool hasExpected;
+    uint64_t expected;
+
+    uint64_t nodes;
+    uint64_t timeNs;
+    struct PerftStats stats;
+    struct CounterValues counters;
+
+    /* The root moves and the node count after each of them (if dividing). */
+    struct CSC_MoveList* root;
+    uint64_t* divide;
+};
+
+/* The jobs to run, which can be shared between threads. */
+struct JobList
+{
+    struct Job* jobs;
+    int n;
+    const struct Options* options;
+    struct PerftTable* table;
+    struct TaskQueue queue;
+};
+
+void PrintUsage()
+{
+    fprintf(stderr,
+        "Usage: chessic_perft (--fen FEN [--depth N] | --epd FILE"
+        " [--min-depth N] [--max-depth N]) [--divide] [--threads N]"
+        " [--split moves|positions] [--hash MB] [--no-counters]\n");
+    fprintf(stderr,
+        "  --fen FEN      Run perft on the position.\n"
+        "  --depth N      The depth for --fen (default 5).\n"
+        "  --epd FILE     Run the positions and depths in the EPD file (in the\n"
+        "                 perftsuite.epd format) and check the node counts.\n");
+    fprintf(stderr,
+        "  --min-depth N  Skip EPD entries shallower than this (at least 1).\n"
+        "  --max-depth N  Skip EPD entries deeper than this.\n"
+        "  --divide       Report the node count for each root move.\n");
+    fprintf(stderr,
+        "  --threads N    The number of threads to use (default 1).\n"
+        "  --split S      Either split the moves of each position between the\n"
+        "                 threads (moves, the default) or run whole positions\n"
+        "                 on each thread (positions).\n");
+    fprintf(stderr,
+        "  --hash MB      Cache the node counts in a hash table of this size\n"
+        "                 (shared by all threads).\n"
+        "  --no-counters  Don't read the hardware performance counters.\n"
+        "The results are written to stdout as JSON.\n");
+}
+
+bool ParseOptions(int argc, char** argv, struct Options* options)
+{
+    int i;
+
+    options->fen = NULL;
+    options->epd = NULL;
+    options->depth = 5;
+    options->minDepth = 1;
+    options->maxDepth = MAX_PERFT_DEPTH;
+    options->divide = false;
+    options->threads = 1;
+    options->hashMB = 0;
+    options->splitPositions = false;
+    options->counters = true;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--divide") == 0)
+        {
+            options->divide = true;
+        }
+        else if (strcmp(argv[i], "--no-counters") == 0)
+        {
+            options->counters = false;
+        }
+        else if (i + 1 == argc)
+        {
+            return false;
+        }
+        else if (strcmp(argv[i], "--fen") == 0)
+        {
+            options->fen = argv[++i];
+        }
+        else if (strcmp(argv[i], "--epd") == 0)
+        {
+            options->epd = argv[++i];
+        }
+        else if (strcmp(argv[i], "--depth") == 0)
+        {
+            options->depth = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--min-depth") == 0)
+        {
+            options->minDepth = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-depth") == 0)
+        {
+            options->maxDepth = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            options->threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--hash") == 0)
+        {
+            options->hashMB = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--split") == 0)
+        {
+            ++i;
+            if (strcmp(argv[i], "positions") == 0)
+                options->splitPositions = true;
+            else if (strcmp(argv[i], "moves") != 0)
+                return false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (options->depth < 1 || options->depth > MAX_PERFT_DEPTH) return false;
+
+    /* Divided and parallel perft split the root moves, so EPD entries at depth
+       0 are always skipped. */
+    if (options->minDepth < 1) return false;
+    if (options->maxDepth > MAX_PERFT_DEPTH) options->maxDepth = MAX_PERFT_DEPTH;
+    if (options->threads < 1 || options->hashMB < 0) return false;
+
+    return (options->fen == NULL) != (options->epd == NULL);
+}
+
+/* Run perft on the position using the number of threads. */
+void RunJob(
+    struct Job* job,
+    const struct Options* options,
+    struct PerftTable* table,
+    int threads)
+{
+    struct CSC_Board* b = CSC_BoardFromFEN(job->fen);
+    struct PerftState* ps = CreatePerftState(b);
+    struct Counters counters;
+    uint64_t start;
+    int i;
+
+    ps->table = table;
+
+    if (options->divide || threads > 1)
+    {
+        job->root = CSC_MakeMoveList();
+        job->divide = malloc(CSC_MAX_MOVES*sizeof(uint64_t));
+    }
+
+    /* The counters include the threads which ParallelPerft creates. */
+    if (options->counters)
+    {
+        OpenCounters(&counters);
+        StartCounters(&counters);
+    }
+
+    start = ClockNs();
+
+    if (threads > 1)
+    {
+        job->nodes = ParallelPerft(
+            b,
+            job->depth,
+            threads,
+            table,
+            job->root,
+            job->divide,
+            &job->stats);
+    }
+    else if (options->divide)
+    {
+        CSC_GetMovesNoDrawCheck(b, job->root, CSC_ALL);
+
+        job->nodes = 0;
+        for (i = 0; i < job->root->n; i++)
+        {
+            CSC_MakeMove(b, job->root->moves[i]);
+            job->divide[i] = Perft(ps, job->depth - 1);
+            CSC_UndoMove(b);
+
+            job->nodes += job->divide[i];
+        }
+    }
+    else
+    {
+        job->nodes = Perft(ps, job->depth);
+    }
+
+    job->timeNs = ClockNs() - start;
+
+    if (options->counters)
+    {
+        StopCounters(&counters, &job->counters);
+        CloseCounters(&counters);
+    }
+
+    job->stats.probes += ps->stats.probes;
+    job->stats.hits += ps->stats.hits;
+
+    FreePerftState(ps);
+}
+
+/* Each thread runs whole jobs on its own. */
+void* JobWorker(void* arg)
+{
+    struct JobList* list = arg;
+    int j;
+
+    while ((j = TakeTask(&list->queue)) >= 0)
+    {
+        RunJob(&list->jobs[j], list->options, list->table, 1);
+    }
+
+    return NULL;
+}
+
+void PrintStats(const struct PerftStats* stats, const char* indent)
+{
+    printf(",\n%s\"hash_probes\": %" PRIu64 ",\n", indent, stats->probes);
+    printf("%s\"hash_hits\": %" PRIu64 ",\n", indent, stats->hits);
+    printf("%s\"hash_hit_rate\": %.4f", indent,
+        stats->probes > 0 ? (double)stats->hits/stats->probes : 0.0);
+}
+
+void PrintCounters(const struct CounterValues* values, const char* indent)
+{
+    int c;
+
+    for (c = 0; c < COUNTER_NB; c++)
+    {
+        if (!values->valid[c]) continue;
+        printf(",\n%s\"%s\": %" PRIu64, indent, CounterNames[c], values->counts[c]);
+    }
+}
+
+/* Write the result as a JSON object. */
+void PrintJob(const struct Job* job, bool first, const struct Options* options)
+{
+    char move[CSC_MAX_UCI_MOVE_LENGTH];
+    bool ok = !job->hasExpected || job->nodes == job->expected;
+    int i;
+
+    printf("%s\n    {\n", first ? "" : ",");
+    printf("      \"fen\": \"%s\",\n", job->fen);
+    printf("      \"depth\": %d,\n", job->depth);
+    printf("      \"nodes\": %" PRIu64 ",\n", job->nodes);
+
+    if (job->hasExpected)
+    {
+        printf("      \"expected\": %" PRIu64 ",\n", job->expected);
+        printf("      \"ok\": %s,\n", ok ? "true" : "false");
+    }
+
+    printf("      \"time_ns\": %" PRIu64 ",\n", job->timeNs);
+    printf("      \"nps\": %.0f",
+        job->timeNs > 0 ? 1e9*job->nodes/job->timeNs : 0.0);
+
+    if (options->hashMB > 0) PrintStats(&job->stats, "      ");
+    if (options->counters) PrintCounters(&job->counters, "      ");
+
+    if (options->divide)
+    {
+        printf(",\n      \"divide\": [");
+        for (i = 0; i < job->root->n; i++)
+        {
+            memset(move, 0, sizeof(move));
+            CSC_MoveToUCIString(job->root->moves[i], move, NULL);
+            printf("%s\n        { \"move\": \"%s\", \"nodes\": %" PRIu64 " }",
+                i > 0 ? "," : "",
+                move,
+                job->divide[i]);
+        }
+
+        printf("\n      ]");
+    }
+
+    printf("\n    }");
+    fflush(stdout);
+
+    if (!ok)
+    {
+        fprintf(stderr, "%s depth %d: expected %" PRIu64 " but got %" PRIu64 "\n",
+            job->fen,
+            job->depth,
+            job->expected,
+            job->nodes);
+    }
+}
+
+void AddJob(
+    struct JobList* list,
+    const char* fen,
+    int depth,
+    bool hasExpected,
+    uint64_t expected)
+{
+    struct Job* job;
+    size_t n = strlen(fen);
+
+    if (n >= CSC_MAX_FEN_LENGTH) n = CSC_MAX_FEN_LENGTH - 1;
+
+    list->jobs = realloc(list->jobs, (list->n + 1)*sizeof(struct Job));
+    job = &list->jobs[list->n++];
+
+    memset(job, 0, sizeof(struct Job));
+    memcpy(job->fen, fen, n);
+    job->depth = depth;
+    job->hasExpected = hasExpected;
+    job->expected = expected;
+}
+
+/* Parse an unsigned number (strtoull isn't available in ANSI C). */
+uint64_t ParseCount(const char** s)
+{
+    uint64_t n = 0;
+
+    while (isspace(**s)) (*s)++;
+    while (isdigit(**s)) n = 10*n + (*(*s)++ - '0');
+
+    return n;
+}
+
+/* Each line of the file is a FEN followed by the expected node counts at each
+   depth e.g. "<FEN> ;D1 20 ;D2 400". */
+bool LoadEPD(const struct Options* options, struct JobList* list)
+{
+    char line[MAX_LINE_LENGTH];
+    char* fen, *end;
+    const char* entry;
+    size_t n;
+    uint64_t expected;
+    int depth;
+    FILE* f = fopen(options->epd, "r");
+
+    if (f == NULL)
+    {
+        fprintf(stderr, "Could not open %s\n", options->epd);
+        return false;
+    }
+
+    while (fgets(line, MAX_LINE_LENGTH, f))
+    {
+        end = strchr(line, ';');
+        if (end == NULL) continue;
+
+        *end = '\0';
+        entry = end + 1;
+
+        fen = line;
+        n = strlen(fen);
+        while (n > 0 && isspace(fen[n - 1])) fen[--n] = '\0';
+        if (n == 0) continue;
+
+        while ((entry = strchr(entry, 'D')) != NULL)
+        {
+            entry++;
+            depth = (int)ParseCount(&entry);
+            expected = ParseCount(&entry);
+
+            if (depth >= options->minDepth && depth <= options->maxDepth)
+            {
+                AddJob(list, fen, depth, true, expected);
+            }
+        }
+    }
+
+    fclose(f);
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    struct Options options;
+    struct JobList list;
+    struct Job* job;
+    struct PerftStats stats = { 0, 0 };
+    struct Counters counters;
+    struct CounterValues totals;
+    uint64_t nodes = 0, timeNs = 0, start, wallNs;
+    int failures = 0, j;
+
+    if (!ParseOptions(argc, argv, &options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    CSC_InitBits();
+    CSC_InitZobrist();
+
+    /* Check that the counters can be read before running anything. */
+    if (options.counters)
+    {
+        if (!OpenCounters(&counters))
+        {
+            fprintf(stderr, "The hardware counters are unavailable.\n");
+            options.counters = false;
+        }
+
+        CloseCounters(&counters);
+    }
+    ClearCounterValues(&totals);
+
+    list.jobs = NULL;
+    list.n = 0;
+    list.options = &options;
+    list.table = NULL;
+
+    if (options.hashMB > 0)
+    {
+        list.table = CreatePerftTable(options.hashMB);
+        if (list.table == NULL)
+        {
+            fprintf(stderr, "Could not allocate a %dMB hash table\n", options.hashMB);
+            return 1;
+        }
+    }
+
+    if (options.fen != NULL)
+    {
+        AddJob(&list, options.fen, options.depth, false, 0);
+    }
+    else if (!LoadEPD(&options, &list))
+    {
+        return 1;
+    }
+
+    printf("{\n  \"results\": [");
+
+    start = ClockNs();
+
+    if (options.splitPositions)
+    {
+        InitTaskQueue(&list.queue, list.n);
+        RunThreads(options.threads, JobWorker, &list);
+        FreeTaskQueue(&list.queue);
+
+        for (j = 0; j < list.n; j++)
+        {
+            PrintJob(&list.jobs[j], j == 0, &options);
+        }
+    }
+    else
+    {
+        for (j = 0; j < list.n; j++)
+        {
+            fprintf(stderr, "%s depth %d\n", list.jobs[j].fen, list.jobs[j].depth);
+            RunJob(&list.jobs[j], &options, list.table, options.threads);
+            PrintJob(&list.jobs[j], j == 0, &options);
+        }
+    }
+
+    wallNs = ClockNs() - start;
+
+    for (j = 0; j < list.n; j++)
+    {
+        job = &list.jobs[j];
+
+        nodes += job->nodes;
+        timeNs += job->timeNs;
+        failures += job->hasExpected && job->nodes != job->expected;
+        stats.probes += job->stats.probes;
+        stats.hits += job->stats.hits;
+        if (options.counters) AddCounterValues(&totals, &job->counters);
+
+        if (job->root != NULL) CSC_FreeMoveList(job->root);
+        free(job->divide);
+    }
+
+    free(list.jobs);
+    FreePerftTable(list.table);
+
+    /* The total time is the sum of the times for each position, which is more
+       than the wall time if the positions are run in parallel. */
+    printf("\n  ],\n");
+    printf("  \"threads\": %d,\n", options.threads);
+    printf("  \"total_nodes\": %" PRIu64 ",\n", nodes);
+    printf("  \"total_time_ns\": %" PRIu64 ",\n", timeNs);
+    printf("  \"wall_time_ns\": %" PRIu64 ",\n", wallNs);
+    printf("  \"nps\": %.0f", wallNs > 0 ? 1e9*nodes/wallNs : 0.0);
+    if (options.hashMB > 0) PrintStats(&stats, "  ");
+    if (options.counters) PrintCounters(&totals, "  ");
+    printf(",\n  \"failures\": %d\n}\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
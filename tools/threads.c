@@ -0,0 +1,43 @@
+#include "threads.h"
+#include "stdlib.h"
+
+void InitTaskQueue(struct TaskQueue* queue, int size)
+{
+    pthread_mutex_init(&queue->lock, NULL);
+    queue->next = 0;
+    queue->size = size;
+}
+
+void FreeTaskQueue(struct TaskQueue* queue)
+{
+    pthread_mutex_destroy(&queue->lock);
+}
+
+int TakeTask(struct TaskQueue* queue)
+{
+    int task;
+
+    pthread_mutex_lock(&queue->lock);
+    task = queue->next < queue->size ? queue->next++ : -1;
+    pthread_mutex_unlock(&queue->lock);
+
+    return task;
+}
+
+void RunThreads(int threads, void* (*worker)(void*), void* arg)
+{
+    pthread_t* ids = malloc(threads*sizeof(pthread_t));
+    int i;
+
+    for (i = 0; i < threads; i++)
+    {
+        pthread_create(&ids[i], NULL, worker, arg);
+    }
+
+    for (i = 0; i < threads; i++)
+    {
+        pthread_join(ids[i], NULL);
+    }
+
+    free(ids);
+}
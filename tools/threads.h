@@ -0,0 +1,25 @@
+#ifndef __CHESSIC_TOOLS_THREADS_H__
+#define __CHESSIC_TOOLS_THREADS_H__
+
+#include "pthread.h"
+
+/* Hands out the indices of the tasks to the worker threads. */
+struct TaskQueue
+{
+    pthread_mutex_t lock;
+    int next;
+    int size;
+};
+
+void InitTaskQueue(struct TaskQueue*, int size);
+
+void FreeTaskQueue(struct TaskQueue*);
+
+/* Get the index of the next task (or -1 if there are none left). */
+int TakeTask(struct TaskQueue*);
+
+/* Run the worker function on the number of threads and wait for them all to
+   finish. Every thread is given the same argument. */
+void RunThreads(int threads, void* (*worker)(void*), void* arg);
+
+#endif /* __CHESSIC_TOOLS_THREADS_H__ */